@@ -88,16 +88,16 @@ int main() {
             -1, 0, 0;
 
         // place the antennas
-        scene->rx = NFAntenna {
+        scene->rx = { NFAntenna {
             rotation * Vector3f(380_mm, 0_mm, 0_mm), // location of the receive antenna
             rotation * facing,                       // local coordinate system of the antenna
             AWRAngularDistribution()                 // radiation pattern
-        };
-        scene->tx = NFAntenna {
+        } };
+        scene->tx = { NFAntenna {
             rotation * Vector3f(380_mm, 0_mm, 0_mm), // location of the transmit antenna
             rotation * facing,                       // local coordinate system of the antenna
             AWRAngularDistribution()                 // radiation pattern
-        };
+        } };
 
         // run the simulation
         integrator->run(backend, *scene, sampleCount);
@@ -2,6 +2,7 @@
 #include <fstream>
 
 #include <radar/units.h>
+#include <radar/container.h>
 
 #include <hussar/hussar.h>
 #include <hussar/core/frame.h>
@@ -78,6 +79,8 @@ int main() {
     // debug images provide some insights into surface currents
     integrator->produceDebugImage = true;
     integrator->configureFrame(frameConfig);
+    // every pose is simulated independently with the full sample budget, which reproduces the
+    // simulations in `evaluation/simulation` (see `5_adaptive_sweep` for a faster, adaptive sweep)
 
     // for this example, we will use the CPU backend
     // note that running on GPU is as simple as replacing 'cpu::Backend' with 'gpu::Backend'
@@ -86,6 +89,10 @@ int main() {
     // all simulated frames will end up concatenated in a single file
     std::ofstream file("dihedral.SIM");
 
+    // additionally, we store the frames in a container that describes the radar configuration
+    // and remembers the angle of each frame
+    radar::ContainerWriter container("dihedral.rcube", rf, frameConfig);
+
     // simulate the Radar response for a range of angles
     for (float angleDeg = -55; angleDeg <= +55; angleDeg += 0.25) {
         // we are rotating our antennas around the y axis
@@ -100,16 +107,21 @@ int main() {
             -1, 0, 0;
 
         // place the antennas
-        scene->rx = NFAntenna {
-            rotation * Vector3f(896_mm, 67_mm, -5_mm), // location of the receive antenna
-            rotation * facing,                         // local coordinate system of the antenna
-            AWRAngularDistribution()                   // radiation pattern
-        };
-        scene->tx = NFAntenna {
+        // the receive antennas are spaced by half a wavelength, one per channel of the frame
+        const float rxSpacing = radar::SPEED_OF_LIGHT / rf.startFreq / 2;
+        scene->rx.clear();
+        for (int channel = 0; channel < Scene::MaxReceivers; ++channel) {
+            scene->rx.push_back(NFAntenna {
+                rotation * Vector3f(896_mm, 67_mm, -5_mm + channel * rxSpacing), // location of the receive antenna
+                rotation * facing,                                               // local coordinate system of the antenna
+                AWRAngularDistribution()                                         // radiation pattern
+            });
+        }
+        scene->tx = { NFAntenna {
             rotation * Vector3f(896_mm, 67_mm, -7_mm), // location of the transmit antenna
             rotation * facing,                         // local coordinate system of the antenna
             AWRAngularDistribution()                   // radiation pattern
-        };
+        } };
 
         // run the simulation
         integrator->run(backend, *scene, sampleCount);
@@ -124,5 +136,6 @@ int main() {
 
         frame = integrator->fetchFrame();
         writeFrameToFile(file, frame);
+        container.write(frame, angleDeg);
     }
 }
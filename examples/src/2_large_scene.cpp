@@ -143,6 +143,8 @@ int main() {
     auto integrator = hussar::make_shared<PathTracer>();
     integrator->produceDebugImage = true;
     integrator->configureFrame(frameConfig);
+    // consecutive poses are similar, hence guiding can start from the distribution of the previous pose
+    integrator->warmStartGuiding = true;
 
     gpu::Backend backend { mesh, *integrator };
 
@@ -150,8 +152,8 @@ int main() {
         Vector3f position { location.transform.block<3, 1>(0, 3) };
         Matrix33f rotation { location.transform.block<3, 3>(0, 0) };
 
-        scene->rx = NFAntenna { position, rotation, AWRAngularDistribution() };
-        scene->tx = scene->rx;
+        scene->tx = { NFAntenna { position, rotation, AWRAngularDistribution() } };
+        scene->rx = { scene->tx[0] };
         scene->rfConfig = rf;
 
         {
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include <hussar/hussar.h>
+#include <hussar/core/frame.h>
+
+using namespace std;
+using namespace hussar;
+using namespace radar;
+
+/**
+ * Benchmarks how splatting into radar frames scales with the number of threads, comparing a single
+ * shared frame (atomic updates) against private frames per thread that are reduced afterwards
+ * (as used by `Integrator::perThreadFrames`).
+ *
+ * Contributions are concentrated around a few range bins, similar to what happens when simulating
+ * simple reflectors such as the dihedral in `1_dihedral`.
+ */
+
+constexpr long SPLATS_PER_THREAD = 50*1000;
+
+/// Generates the contributions that a thread will splat (the same for both strategies).
+std::vector<std::pair<RadarFrame::PIndex, Complex>> makeContributions(const FrameConfig &config, int seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<Float> range(40, 0.5);
+    std::uniform_real_distribution<Float> phase(0, 2 * Pi);
+
+    std::vector<std::pair<RadarFrame::PIndex, Complex>> result(SPLATS_PER_THREAD);
+    for (auto &[index, value] : result) {
+        index.sample = range(rng);
+        index.chirp = 0;
+        index.channel = rng() % config.channelCount;
+        value = radar::polar(Float(1), phase(rng));
+    }
+    return result;
+}
+
+/// Runs a function on a given number of threads and returns the wall time it took (in [ms]).
+template<typename F>
+float measure(int threadCount, F &&fn) {
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i)
+        threads.emplace_back(fn, i);
+    for (auto &thread : threads)
+        thread.join();
+
+    auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.f;
+}
+
+int main() {
+    radar::FrameConfig frameConfig;
+    frameConfig.chirpCount      = 128;
+    frameConfig.samplesPerChirp = 256;
+    frameConfig.channelCount    = 4;
+
+    const int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::vector<std::pair<RadarFrame::PIndex, Complex>>> contributions;
+    for (int i = 0; i < maxThreads; ++i)
+        contributions.push_back(makeContributions(frameConfig, i));
+
+    std::cout << "threads | shared (atomic) [Msplats/s] | per-thread + reduce [Msplats/s]" << std::endl;
+
+    for (int threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        const float totalSplats = Float(SPLATS_PER_THREAD) * threadCount;
+
+        // a single frame shared by all threads
+        RadarFrame shared;
+        shared.configure(frameConfig);
+        shared.clear();
+
+        float sharedTime = measure(threadCount, [&](int thread) {
+            for (auto &[index, value] : contributions[thread])
+                shared.splat(index, value);
+        });
+
+        // private frames that are summed up afterwards
+        RadarFrame reduced;
+        reduced.configure(frameConfig);
+        reduced.clear();
+
+        WorkerFrames workers;
+        workers.configure(frameConfig, threadCount);
+
+        float privateTime = measure(threadCount, [&](int thread) {
+            for (auto &[index, value] : contributions[thread])
+                workers.frame(thread).splat<16, false>(index, value);
+        });
+
+        constexpr size_t ChunkSize = 4096;
+        std::atomic<size_t> nextChunk(0);
+        privateTime += measure(threadCount, [&](int) {
+            size_t begin;
+            while ((begin = ChunkSize * nextChunk++) < reduced.sampleCount())
+                workers.reduce(reduced, begin, std::min(begin + ChunkSize, reduced.sampleCount()));
+        });
+
+        std::cout
+            << std::setw(7) << threadCount << " | "
+            << std::setw(27) << totalSplats / sharedTime / 1e3 << " | "
+            << std::setw(31) << totalSplats / privateTime / 1e3
+            << std::endl;
+    }
+}
@@ -0,0 +1,59 @@
+#include <iostream>
+#include <filesystem>
+
+#include <radar/dataset.h>
+
+#include <hussar/hussar.h>
+#include <hussar/core/frame.h>
+#include <hussar/core/thread.h>
+
+#include "utils.h"
+
+using namespace std;
+using namespace hussar;
+using namespace radar;
+
+/**
+ * Compares our simulations of dihedral reflectors with our measurements thereof
+ * (this is the native counterpart to evaluation/OurMeasurements.ipynb).
+ */
+int main(int argc, char **argv) {
+    // the directory containing the 'measurements' and 'simulation' folders
+    const std::string evaluation = argc > 1 ? argv[1] : "../evaluation";
+
+    // the files contain one range profile (256 samples) per angle of the sweep
+    radar::FrameConfig frameConfig;
+    frameConfig.chirpCount      = 1;
+    frameConfig.samplesPerChirp = 256;
+    frameConfig.channelCount    = 1;
+    const size_t frameSize = frameConfig.sampleCount() * sizeof(radar::Complex);
+
+    // the scale of our simulation needs to be calibrated to the gain of the sensor
+    radar::ComparisonOptions options;
+    options.scale = 1 / 9.2f;
+    options.tolerance = 0.5; // in [deg]
+
+    for (const char *name : { "dihedral-5cm", "dihedral-7cm", "dihedral-10cm", "dihedral-15cm" }) {
+        const std::string measurementPath = evaluation + "/measurements/" + name;
+        const std::string simulationPath = evaluation + "/simulation/" + name;
+
+        // the angles covered by the sweeps of our measurement setup and our simulations
+        const int measuredAngles = int(std::filesystem::file_size(measurementPath) / frameSize);
+        const int simulatedAngles = int(std::filesystem::file_size(simulationPath) / frameSize);
+        radar::Dataset measurement(measurementPath, frameConfig, 53.8 - 2.8, -2 * 53.8 / (measuredAngles - 1));
+        radar::Dataset simulation(simulationPath, frameConfig, -75, 150.0 / (simulatedAngles - 1));
+
+        radar::Comparison comparison;
+        {
+            Timer timer(std::string("comparison of ") + name);
+            comparison = radar::compare(measurement, simulation, options, [](const std::function<void (int)> &task) {
+                ThreadPool::get().parallel(task);
+            });
+        }
+
+        std::cout << "- " << comparison.frames.size() << " aligned angles" << std::endl;
+        std::cout << "- magnitude error: " << comparison.magnitudeError << std::endl;
+        std::cout << "- correlation:     " << comparison.correlation << std::endl;
+        std::cout << "- peak distance:   " << comparison.peakDistance << " bins" << std::endl;
+    }
+}
@@ -0,0 +1,127 @@
+#include <iostream>
+
+#include <radar/units.h>
+#include <radar/container.h>
+
+#include <hussar/hussar.h>
+#include <hussar/core/frame.h>
+#include <hussar/core/mesh.h>
+#include <hussar/core/geometry.h>
+#include <hussar/core/scene.h>
+#include <hussar/core/emitter.h>
+#include <hussar/integrators/path.h>
+
+#include <hussar/arch/cpu.h>
+
+#include "utils.h"
+
+using namespace std;
+using namespace hussar;
+using namespace radar;
+
+/**
+ * Simulates the dihedral sweep of `1_dihedral`, but stops each pose once its frame has converged and
+ * starts guiding from the distribution of the previous pose.
+ * Each pose therefore takes a varying amount of samples and depends on the poses before it, hence
+ * the output differs from the simulations in `evaluation/simulation`.
+ */
+int main() {
+    /// MARK: Radar configuration
+
+    // configure the parameters of the FMCW ramps
+    radar::RFConfig rf;
+    rf.antennaDelay = 0.43_ns;
+
+    rf.startFreq = 77_GHz;
+    rf.freqSlope = 60_MHz / 1_us;
+    rf.adcRate   = 5_MHz;
+    rf.idleTime  = 100_us;
+    rf.rampTime  = 60_us;
+
+    // configure the parameters of captured frames
+    radar::FrameConfig frameConfig;
+    frameConfig.chirpCount      = 128;
+    frameConfig.samplesPerChirp = 256;
+    frameConfig.channelCount    = 4;
+
+    // the budget is an upper bound, most poses converge long before it is used up
+    long sampleCount = 200*1000;
+
+    /// MARK: Scene mesh
+
+    TriangleMesh mesh;
+
+    /// edge length of the two rectangles that make up the dihedral reflector
+    float size = 50_mm;
+
+    // first side of the dihedral reflector
+    mesh.addBox(
+        Vector3f(-2_mm, +0_mm, +0_mm),
+        Vector3f(-0_mm, +size, +size)
+    );
+
+    // second side of the dihedral reflector
+    mesh.addBox(
+        Vector3f(+0_mm, +0_mm, -2_mm),
+        Vector3f(+size, +size, -0_mm)
+    );
+
+    /// MARK: Simulation
+
+    auto scene = hussar::make_shared<Scene>();
+    scene->rfConfig = rf;
+
+    auto integrator = hussar::make_shared<PathTracer>();
+    integrator->configureFrame(frameConfig);
+    // stop sampling a pose once the relative error of its strongest bin falls below 1%
+    integrator->targetRelativeError = 0.01f;
+    // consecutive poses are similar, hence guiding can start from the distribution of the previous pose
+    integrator->warmStartGuiding = true;
+    // guiding stops training once an iteration reduces the variance by less than 10%
+    integrator->schedule.minVarianceReduction = 0.1f;
+
+    cpu::Backend backend { mesh, *integrator };
+
+    // the frames are stored in a container that remembers the angle of each frame
+    radar::ContainerWriter container("dihedral_adaptive.rcube", rf, frameConfig);
+
+    Timer timer("adaptive sweep");
+    for (float angleDeg = -55; angleDeg <= +55; angleDeg += 0.25) {
+        // we are rotating our antennas around the y axis
+        Matrix33f rotation = Eigen::AngleAxisf((angleDeg-45) / 180 * Pi, Vector3f::UnitY()).toRotationMatrix();
+
+        // the local coordinate system of our antennas
+        Matrix33f facing;
+        facing <<
+            0, 0, -1,
+            0, -1, 0,
+            -1, 0, 0;
+
+        // the receive antennas are spaced by half a wavelength, one per channel of the frame
+        const float rxSpacing = radar::SPEED_OF_LIGHT / rf.startFreq / 2;
+        scene->rx.clear();
+        for (int channel = 0; channel < Scene::MaxReceivers; ++channel) {
+            scene->rx.push_back(NFAntenna {
+                rotation * Vector3f(896_mm, 67_mm, -5_mm + channel * rxSpacing),
+                rotation * facing,
+                AWRAngularDistribution()
+            });
+        }
+        scene->tx = { NFAntenna {
+            rotation * Vector3f(896_mm, 67_mm, -7_mm),
+            rotation * facing,
+            AWRAngularDistribution()
+        } };
+
+        integrator->run(backend, *scene, sampleCount);
+
+        // every ten steps report the current angle along with the error that its frame has converged to
+        static int i = 0;
+        if (++i >= 10) {
+            std::cout << "angle: " << angleDeg << " (peak error: " << integrator->errorEstimate().peakRelativeError << ")" << std::endl;
+            i = 0;
+        }
+
+        container.write(integrator->fetchFrame(), angleDeg);
+    }
+}
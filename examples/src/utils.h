@@ -27,10 +27,8 @@ private:
 };
 
 void writeFrameToFile(std::ofstream &file, const hussar::RadarFrame &frame) {
-    for (size_t i = 0; i < frame.sampleCount(); ++i) {
-        auto v = frame(i);
-        file.write((const char *)(&v), 2 * sizeof(radar::Float));
-    }
+    // one write for the whole frame (the data is stored as interleaved real and imaginary parts)
+    file.write((const char *)frame.data(), frame.sampleCount() * sizeof(radar::Complex));
     file.flush();
 }
 
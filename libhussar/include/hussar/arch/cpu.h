@@ -4,6 +4,11 @@
 #include <hussar/hussar.h>
 #include <hussar/core/mesh.h>
 #include <hussar/core/integrator.h>
+#include <hussar/core/scheduler.h>
+#include <hussar/core/thread.h>
+
+#include <memory>
+#include <vector>
 
 typedef struct RTCSceneTy* RTCScene;
 
@@ -19,28 +24,63 @@ struct Backend {
     Backend(const TriangleMesh &mesh, Integrator &integrator)
     : m_rt(mesh) {
         m_run = [&](const Scene &scene, long budget, bool *interruptFlag) {
-            long sampleCount = 0;
-            std::mutex scMutex;
-            ThreadPool::get().parallel([&] (int) {
-                while (!interruptFlag || !*interruptFlag) {
-                    int batch;
-                    long index;
-                    {
-                        std::unique_lock lock(scMutex);
-                        batch = std::min<long>(budget - sampleCount, 256); 
-                        if (batch <= 0)
-                            break;
-                        index = sampleCount;
-                        sampleCount += batch;
+            const int workerCount = m_session ?
+                m_session->workerCount() :
+                ThreadPool::get().threadCount();
+
+            integrator.prepareWorkers(workerCount);
+            m_scheduler.reset(budget, workerCount);
+
+            parallel([&](int worker) {
+                integrator.runBackgroundTasks();
+
+                long begin, end;
+                while ((!interruptFlag || !*interruptFlag) && m_scheduler.next(worker, begin, end)) {
+                    if (integrator.wavefront) {
+                        integrator.sampleWavefront(scene, m_rt, begin, end, worker);
+                        continue;
                     }
-                    
-                    for (int j = 0; j < batch; ++j)
-                        integrator.sample(scene, m_rt, index + j);
+
+                    integrator.sampleRange(scene, m_rt, begin, end, worker);
                 }
             });
+
+            integrator.reduceWorkers([&](const std::function<void (int)> &task) {
+                parallel(task);
+            });
         };
     }
 
+    /**
+     * @brief Keeps the worker threads of this backend dispatched for as long as the returned object
+     * lives, so that consecutive calls to `run` (e.g. guiding iterations) do not need to queue new
+     * jobs on the thread pool.
+     *
+     * Sessions can be nested, in which case only the outermost one has an effect.
+     */
+    class Session {
+    public:
+        Session(Backend &backend) : m_backend(backend), m_isOwner(!backend.m_session) {
+            if (m_isOwner)
+                m_backend.m_session = std::make_unique<ParallelSession>();
+        }
+
+        Session(const Session &) = delete;
+
+        ~Session() {
+            if (m_isOwner)
+                m_backend.m_session.reset();
+        }
+
+    private:
+        Backend &m_backend;
+        bool m_isOwner;
+    };
+
+    Session session() {
+        return Session(*this);
+    }
+
     void run(const Scene &scene, long budget, bool *interruptFlag = nullptr) {
         m_run(scene, budget, interruptFlag);
     }
@@ -54,11 +94,30 @@ private:
         bool visible(Intersection &isect) const;
         void intersect(Intersection &isect) const;
 
+        /// Tests the visibility of multiple shadow rays at once using ray packets.
+        void visible(Intersection *const *isects, bool *results, size_t count) const;
+        /// Intersects multiple rays with the scene at once using ray packets.
+        void intersect(Intersection *const *isects, size_t count) const;
+
     private:
+        /// Records the velocity of the surface that has been hit (see `TriangleMesh::Motion`).
+        void applyMotion(Intersection &isect, unsigned int primID) const;
+
         RTCScene m_scene;
+        std::vector<TriangleMesh::Motion> m_motions;
+        std::vector<int> m_motionIndices; ///< empty if the scene is static
     };
 
+    void parallel(const std::function<void (int)> &task) {
+        if (m_session)
+            m_session->parallel(task);
+        else
+            ThreadPool::get().parallel(task);
+    }
+
     RT m_rt;
+    SampleScheduler m_scheduler;
+    std::unique_ptr<ParallelSession> m_session;
     std::function<void (const Scene &scene, long, bool *)> m_run;
 };
 #else
@@ -68,6 +127,9 @@ struct Backend {
         Log(EError, "CPU backend is not available as libhussar was compiled without embree");
     }
 
+    struct Session {};
+    Session session() { return {}; }
+
     void run(const Scene &, long, bool *) {}
 };
 #endif
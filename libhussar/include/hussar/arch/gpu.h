@@ -31,6 +31,10 @@ struct Backend {
         m_run(scene, budget);
     }
 
+    /// Work is dispatched to the GPU for every run, hence sessions have no effect on this backend.
+    struct Session {};
+    Session session() { return {}; }
+
 private:
     void run(PathTracer &integrator, const Scene &scene, long budget);
 
@@ -52,6 +56,9 @@ struct Backend {
         Log(EError, "GPU backend is not available as libhussar was compiled without OptiX");
     }
 
+    struct Session {};
+    Session session() { return {}; }
+
     void run(const Scene &, long, bool *) {}
 };
 #endif
@@ -6,8 +6,10 @@
 #include <hussar/core/sampler.h>
 #include <hussar/core/sampling.h>
 #include <hussar/core/intersection.h>
+#include <hussar/core/piecewise.h>
 #include <cmath>
 #include <array>
+#include <vector>
 
 namespace hussar {
 
@@ -72,12 +74,15 @@ public:
     HUSSAR_CPU_GPU void connect(Intersection &outgoing) const {
         Float r = outgoing.t;
         outgoing.ray.addDistance(r);
-        
-        Complex green = (
-            Complex(0, incoming.ray.k0())  // j*k
+        outgoing.ray.weightBy(green(incoming.ray.k0(), r));
+    }
+
+    /// The factor by which the field re-radiated at some wave number decays over a distance.
+    HUSSAR_CPU_GPU static Complex green(Float k0, Float r) {
+        return (
+            Complex(0, k0)                 // j*k
             + 1 / std::max(r, Float(1e-3)) // 1/r @todo
         ) / (4*Pi*r);
-        outgoing.ray.weightBy(green);
     }
 };
 
@@ -119,6 +124,11 @@ public:
         return UniformSpherePdf();
     }
 
+    /// Returns the sample that `sample` maps to a given direction.
+    HUSSAR_CPU_GPU Vector2f invert(const Vector3f &d) const {
+        return UniformSampleSphereInverse(d);
+    }
+
     /**
      * @note We do not have precise antenna measurements for our AWR device, so we resort to
      *       a rough approximation of the radiation pattern using simple polynomials.
@@ -136,6 +146,124 @@ public:
     }
 };
 
+/**
+ * @brief A radiation pattern that is given by a table of gains, e.g. from measurements of an antenna.
+ *
+ * The gains scale the same polarization as `AWRAngularDistribution` and are stored on a regular grid in
+ * the parameterization of `UniformSampleSphere`, whose cells all cover the same solid angle. They are
+ * interpolated bilinearly when evaluated, and directions are importance sampled in proportion to the gain
+ * (see `PiecewiseConstant2D`), so that few rays are wasted on directions the antenna barely radiates into.
+ *
+ * @note Antennas refer to the table instead of copying it (see `NFAntenna`). When rendering on the GPU,
+ *       the table needs to be created with `make_shared` so that it resides in managed memory.
+ */
+class TabulatedAngularDistribution {
+public:
+    TabulatedAngularDistribution() {}
+
+    /**
+     * @brief Tabulates a radiation pattern given by a function.
+     *
+     * @param gain Returns the (linear) gain of the field for a direction in the local frame of the antenna.
+     * @param resolution The amount of cells of the table along each axis.
+     */
+    template<typename Gain>
+    TabulatedAngularDistribution(Gain &&gain, int resolution = 128) : m_resolution(resolution) {
+        m_gains.resize(size_t(resolution) * resolution);
+        for (int i = 0; i < resolution; ++i) {
+            for (int j = 0; j < resolution; ++j) {
+                const Vector2f uv((i + Float(0.5)) / resolution, (j + Float(0.5)) / resolution);
+                m_gains[size_t(i) * resolution + j] = std::max(Float(gain(UniformSampleSphere(uv))), Float(0));
+            }
+        }
+
+        // the largest gain within each cell, which occurs at its center, corners or edge midpoints
+        std::vector<Float> densities(m_gains.size());
+        for (int i = 0; i < resolution; ++i) {
+            for (int j = 0; j < resolution; ++j) {
+                Float maximum = 0;
+                for (int di = -1; di <= 1; ++di)
+                    for (int dj = -1; dj <= 1; ++dj)
+                        maximum = std::max(maximum, lookup(Vector2f(
+                            (i + (di + 1) * Float(0.5)) / resolution,
+                            (j + (dj + 1) * Float(0.5)) / resolution
+                        )));
+                densities[size_t(i) * resolution + j] = maximum;
+            }
+        }
+        m_distribution.build(densities.data(), resolution);
+    }
+
+    /**
+     * @brief Creates a radiation pattern from gains measured on a regular grid of azimuths and elevations.
+     *
+     * The azimuth is measured from the boresight (the z-axis) towards the x-axis and covers [-180°, 180°],
+     * and the elevation is measured towards the y-axis and covers [-90°, 90°]. Directions that have not been
+     * measured should be given a gain of zero.
+     *
+     * @param gains The (linear) gain of the field for each direction, where the gain of the i-th azimuth and
+     *              j-th elevation is found at `gains[i * elevationCount + j]`.
+     */
+    TabulatedAngularDistribution(const Float *gains, int azimuthCount, int elevationCount, int resolution = 128)
+    : TabulatedAngularDistribution([=](const Vector3f &d) {
+        const Float azimuth = std::atan2(d.x(), d.z());
+        const Float elevation = std::asin(std::min(std::max(d.y(), Float(-1)), Float(1)));
+        const Float x = (azimuth + Pi) / (2 * Pi) * (azimuthCount - 1);
+        const Float y = (elevation + Pi / 2) / Pi * (elevationCount - 1);
+
+        const int x0 = std::min(int(x), azimuthCount - 2), y0 = std::min(int(y), elevationCount - 2);
+        const Float fx = x - x0, fy = y - y0;
+        const Float *row0 = gains + size_t(x0) * elevationCount, *row1 = row0 + elevationCount;
+        return (1 - fx) * ((1 - fy) * row0[y0] + fy * row0[y0 + 1]) +
+                    fx  * ((1 - fy) * row1[y0] + fy * row1[y0 + 1]);
+    }, resolution) {
+        Assert(azimuthCount >= 2 && elevationCount >= 2, "at least two azimuths and elevations are required");
+    }
+
+    HUSSAR_CPU_GPU Vector3c sample(const Vector2f &uv, Vector3f &d) const {
+        Vector2f x = uv;
+        const Float pdf = m_distribution.sample(x) * UniformSpherePdf();
+        d = UniformSampleSphere(x);
+        return pdf > 0 ? Vector3c(evaluate(d) / pdf) : Vector3c(Vector3c::Zero());
+    }
+
+    HUSSAR_CPU_GPU Float pdf(const Vector3f &d) const {
+        return m_distribution.pdf(UniformSampleSphereInverse(d)) * UniformSpherePdf();
+    }
+
+    /// Returns the sample that `sample` maps to a given direction.
+    HUSSAR_CPU_GPU Vector2f invert(const Vector3f &d) const {
+        return m_distribution.invert(UniformSampleSphereInverse(d));
+    }
+
+    HUSSAR_CPU_GPU Vector3c evaluate(const Vector3f &d) const {
+        return Vector3c(0, 1, 0).cross(d) * lookup(UniformSampleSphereInverse(d));
+    }
+
+    HUSSAR_CPU_GPU int resolution() const { return m_resolution; }
+
+    /// The gains at the centers of the cells, where cell `(i, j)` is found at `gains()[i * resolution() + j]`.
+    HUSSAR_CPU_GPU const Float *gains() const { return m_gains.data(); }
+
+private:
+    /// Interpolates the gains bilinearly, wrapping around in azimuth.
+    HUSSAR_CPU_GPU Float lookup(const Vector2f &uv) const {
+        const Float x = uv[0] * m_resolution - Float(0.5);
+        const Float y = std::min(std::max(uv[1] * m_resolution - Float(0.5), Float(0)), Float(m_resolution - 1));
+
+        const int x0 = int(std::floor(x)), y0 = std::min(int(y), m_resolution - 2);
+        const Float fx = x - x0, fy = y - y0;
+        const Float *row0 = m_gains.data() + size_t((x0 + m_resolution) % m_resolution) * m_resolution;
+        const Float *row1 = m_gains.data() + size_t((x0 + 1) % m_resolution) * m_resolution;
+        return (1 - fx) * ((1 - fy) * row0[y0] + fy * row0[y0 + 1]) +
+                    fx  * ((1 - fy) * row1[y0] + fy * row1[y0 + 1]);
+    }
+
+    int m_resolution = 0;
+    std::vector<Float, Allocator<Float>> m_gains;
+    PiecewiseConstant2D m_distribution;
+};
+
 class Antenna : public Emitter {
 public:
     HUSSAR_CPU_GPU virtual void sample(const Vector2f &uv, Ray &ray) const = 0;
@@ -154,7 +282,8 @@ public:
  * @brief Models an antenna with infinitissimal area that can be used to simulate radar sensors.
  * 
  * This is equivalent to a point light source in computer graphics.
- * The radiation pattern is determined by the provided AngularDistribution.
+ * The radiation pattern is either the built-in approximation of the AWR1243 antennas or a
+ * `TabulatedAngularDistribution`, which must outlive the antenna.
  */
 class NFAntenna {
 public:
@@ -171,17 +300,38 @@ public:
         );
     }
 
+    HUSSAR_CPU_GPU NFAntenna(
+        const Vector3f &position,
+        const Matrix33f &rotation,
+        const TabulatedAngularDistribution &pattern
+    )
+    : NFAntenna(position, rotation, AWRAngularDistribution()) {
+        m_pattern = &pattern;
+    }
+
     HUSSAR_CPU_GPU void sample(const Vector2f &uv, Ray &ray) const {
         ray.o = m_position;
 
-        Vector3c H = m_radiation.sample(uv, ray.d);
+        Vector3c H = m_pattern ? m_pattern->sample(uv, ray.d) : m_radiation.sample(uv, ray.d);
         ray.d = Vector3f(m_rotation * ray.d);
         ray.setH(m_rotation * H);
     }
 
+    /// Returns the density (per solid angle) with which `sample` produces a direction (in world space).
+    HUSSAR_CPU_GPU Float pdf(const Vector3f &d) const {
+        const Vector3f local = m_rotation.transpose() * d;
+        return m_pattern ? m_pattern->pdf(local) : m_radiation.pdf(local);
+    }
+
+    /// Returns the sample that `sample` maps to a given direction (in world space).
+    HUSSAR_CPU_GPU Vector2f invert(const Vector3f &d) const {
+        const Vector3f local = m_rotation.transpose() * d;
+        return m_pattern ? m_pattern->invert(local) : m_radiation.invert(local);
+    }
+
     HUSSAR_CPU_GPU void evaluate(Ray &ray) const {
         ray.o = m_position;
-        Vector3c H = m_radiation.evaluate(m_rotation.transpose() * ray.d);
+        Vector3c H = radiation(m_rotation.transpose() * ray.d);
         ray.setH(m_rotation * H);
     }
 
@@ -198,7 +348,7 @@ public:
         nee.ray.d /= r;
         nee.tMax = r;
 
-        Vector3c H = m_radiation.evaluate(m_rotation.transpose() * (-nee.ray.d));
+        Vector3c H = radiation(m_rotation.transpose() * (-nee.ray.d));
         return m_rotation * H;
     }
 
@@ -207,10 +357,19 @@ public:
     HUSSAR_CPU_GPU const Vector3f &position() const { return m_position; }
     HUSSAR_CPU_GPU const Matrix33f &rotation() const { return m_rotation; }
 
+    /// The tabulated radiation pattern, or `nullptr` if the antenna uses the AWR1243 approximation.
+    HUSSAR_CPU_GPU const TabulatedAngularDistribution *pattern() const { return m_pattern; }
+
 private:
+    /// Evaluates the radiation pattern for a direction in the local frame of the antenna.
+    HUSSAR_CPU_GPU Vector3c radiation(const Vector3f &d) const {
+        return m_pattern ? m_pattern->evaluate(d) : m_radiation.evaluate(d);
+    }
+
     Vector3f m_position;
     Matrix33f m_rotation;
     AWRAngularDistribution m_radiation;
+    const TabulatedAngularDistribution *m_pattern = nullptr;
 };
 
 /**
@@ -5,10 +5,246 @@
 #include <hussar/hussar.h>
 #include <hussar/core/allocator.h>
 
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
 namespace hussar {
 
 using RadarFrame = radar::Frame<Allocator<radar::Complex>>;
 
+/**
+ * @brief A set of private radar frames, one for each worker thread of a backend.
+ *
+ * Splatting into a single shared frame requires atomic operations on every cell that is touched,
+ * which scales poorly when many threads hit the same few range bins. Instead, each worker can splat
+ * into its own frame without any synchronization, and the frames are summed up once all workers
+ * have finished.
+ */
+class WorkerFrames {
+public:
+    /**
+     * @brief Allocates one zeroed frame for each worker.
+     *
+     * @note Existing frames are kept (including their data) if the configuration did not change.
+     */
+    void configure(const radar::FrameConfig &config, int workerCount) {
+        bool unchanged = int(m_workers.size()) == workerCount;
+        for (int i = 0; i < radar::FrameConfig::NUM_COMPONENTS; ++i)
+            unchanged &= m_config.raw[i] == config.raw[i];
+
+        if (unchanged)
+            return;
+
+        m_config = config;
+        m_workers.clear();
+        m_workers.resize(workerCount);
+        for (auto &worker : m_workers) {
+            worker.frame.configure(config);
+            worker.frame.clear();
+        }
+    }
+
+    /// Returns how many workers frames have been allocated for.
+    int workerCount() const { return int(m_workers.size()); }
+
+    /// Returns the private frame of some worker.
+    RadarFrame &frame(int worker) { return m_workers[worker].frame; }
+
+    /// Returns the private sample weight accumulator of some worker.
+    double &totalWeight(int worker) { return m_workers[worker].totalWeight; }
+
+    /// Sets all private frames and weights to zero.
+    void clear() {
+        for (auto &worker : m_workers) {
+            worker.frame.clear();
+            worker.totalWeight = 0;
+        }
+    }
+
+    /**
+     * @brief Adds the data indices `[begin, end)` of all private frames to a target frame
+     * and sets them to zero.
+     *
+     * Disjoint ranges can be reduced concurrently by different threads.
+     */
+    void reduce(RadarFrame &target, size_t begin, size_t end) {
+        for (auto &worker : m_workers) {
+            for (size_t i = begin; i < end; ++i) {
+                target(i) += worker.frame(i);
+                worker.frame(i) = 0;
+            }
+        }
+    }
+
+    /// Returns the sum of all private sample weights and sets them to zero.
+    double reduceTotalWeight() {
+        double sum = 0;
+        for (auto &worker : m_workers) {
+            sum += worker.totalWeight;
+            worker.totalWeight = 0;
+        }
+        return sum;
+    }
+
+private:
+    /// Aligned to cache lines so that weight updates of different workers do not cause false sharing.
+    struct alignas(64) Worker {
+        RadarFrame frame;
+        double totalWeight = 0;
+    };
+
+    radar::FrameConfig m_config = {};
+    std::vector<Worker> m_workers;
+};
+
+/**
+ * @brief Estimates the statistical error of a simulated frame from the spread of independent batches of samples.
+ *
+ * After every batch, the contribution of the batch is extracted from the accumulated frame (by comparing it
+ * to the previous state) and normalized by the weight of the batch, which yields an independent estimate of
+ * the frame. The spread of these estimates gives the variance of each bin without having to track the second
+ * moment of every single contribution (i.e. the batch means method). Batches are assumed to have equal weights.
+ */
+class BatchStatistics {
+public:
+    /// A summary of the error of the frame.
+    struct Estimate {
+        /// The standard error of the strongest bin relative to its magnitude.
+        Float peakRelativeError = Infinity;
+        /// The standard error of all bins relative to the magnitude of the frame (both as in the L2 norm).
+        Float relativeError = Infinity;
+        /// The index of the strongest bin.
+        size_t peakIndex = 0;
+        /// The amount of batches the estimate is based on.
+        int batchCount = 0;
+    };
+
+    /// Starts a new estimate, using the current state of the accumulated frame as reference.
+    void reset(const RadarFrame &frame) {
+        m_previous = frame;
+        m_sum.configure(frame.config());
+        m_sum.clear();
+        m_sumSquared.configure(frame.config());
+        m_sumSquared.clear();
+        m_batchCount = 0;
+        m_weight = 0;
+    }
+
+    /// Discards all batches (without releasing memory).
+    void clear() {
+        m_batchCount = 0;
+        m_weight = 0;
+    }
+
+    /**
+     * @brief Records the samples that have been added to the accumulated frame since the last call as one batch.
+     *
+     * @param weight The sum of the weights of the samples of this batch.
+     */
+    void record(const RadarFrame &frame, double weight) {
+        if (weight <= 0)
+            return;
+
+        const Float invWeight = Float(1 / weight);
+        for (size_t i = 0; i < frame.sampleCount(); ++i) {
+            const radar::Complex estimate = (frame(i) - m_previous(i)) * invWeight;
+            m_previous(i) = frame(i);
+            m_sum(i) += estimate;
+            // the real and imaginary parts are tracked separately
+            m_sumSquared(i) += radar::Complex(
+                estimate.real() * estimate.real(),
+                estimate.imag() * estimate.imag()
+            );
+        }
+
+        m_batchCount++;
+        m_weight += weight;
+    }
+
+    /// The amount of batches recorded since the last reset.
+    int batchCount() const { return m_batchCount; }
+
+    /// The sum of the weights of all batches recorded since the last reset.
+    double weight() const { return m_weight; }
+
+    /**
+     * @brief Computes the standard error of the real and imaginary parts of a bin of the normalized frame.
+     *
+     * @param scale The fraction of the total weight of the frame that has been recorded. Samples that
+     * were accumulated before the last reset are treated as free of noise.
+     */
+    radar::Complex standardError(size_t i, Float scale = 1) const {
+        if (m_batchCount < 2)
+            return radar::Complex(Infinity, Infinity);
+
+        const Float n = Float(m_batchCount);
+        const radar::Complex mean = m_sum(i) / n;
+        const radar::Complex meanSquared = m_sumSquared(i) / n;
+
+        // unbiased variance of a single batch, divided by the amount of batches to obtain that of their mean
+        const Float factor = scale * scale / (n - 1);
+        return radar::Complex(
+            std::sqrt(std::max(meanSquared.real() - mean.real() * mean.real(), Float(0)) * factor),
+            std::sqrt(std::max(meanSquared.imag() - mean.imag() * mean.imag(), Float(0)) * factor)
+        );
+    }
+
+    /// Sums the variances of all bins of the mean of the batches (i.e. of the frame normalized by `weight`).
+    double totalVariance() const {
+        if (m_batchCount < 2)
+            return Infinity;
+
+        double variance = 0;
+        for (size_t i = 0; i < m_sum.sampleCount(); ++i)
+            variance += std::norm(standardError(i));
+        return variance;
+    }
+
+    /**
+     * @brief Summarizes the error of an accumulated frame (see `standardError`).
+     *
+     * @param totalWeight The weight the accumulated frame is normalized by.
+     */
+    Estimate estimate(const RadarFrame &frame, double totalWeight) const {
+        Estimate result;
+        result.batchCount = m_batchCount;
+        if (m_batchCount < 2 || totalWeight <= 0)
+            return result;
+
+        const Float scale = Float(m_weight / totalWeight);
+        const Float invWeight = Float(1 / totalWeight);
+
+        double energy = 0, variance = 0, peakEnergy = -1, peakVariance = 0;
+        for (size_t i = 0; i < frame.sampleCount(); ++i) {
+            const double binEnergy = std::norm(frame(i) * invWeight);
+            const double binVariance = std::norm(standardError(i, scale));
+            energy += binEnergy;
+            variance += binVariance;
+            if (binEnergy > peakEnergy) {
+                peakEnergy = binEnergy;
+                peakVariance = binVariance;
+                result.peakIndex = i;
+            }
+        }
+
+        if (peakEnergy > 0) {
+            result.relativeError = Float(std::sqrt(variance / energy));
+            result.peakRelativeError = Float(std::sqrt(peakVariance / peakEnergy));
+        }
+        return result;
+    }
+
+private:
+    /// The accumulated frame at the end of the last batch.
+    RadarFrame m_previous;
+    RadarFrame m_sum;
+    /// Holds the sum of the squared real parts in the real component, and likewise for imaginary parts.
+    RadarFrame m_sumSquared;
+    int m_batchCount = 0;
+    double m_weight = 0;
+};
+
 }
 
 #endif
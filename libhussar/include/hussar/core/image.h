@@ -5,6 +5,10 @@
 #include <hussar/core/geometry.h>
 #include <hussar/core/allocator.h>
 
+#include <vector>
+#include <memory>
+#include <algorithm>
+
 namespace hussar {
 
 /**
@@ -79,6 +83,82 @@ private:
     int m_strideX, m_strideY;
 };
 
+/**
+ * @brief Private copies of an image for the CPU workers, which allow splatting without synchronization.
+ *
+ * The copies are split into square tiles so that different threads can reduce them concurrently. All
+ * tiles are allocated when the copies are configured, hence splatting never allocates memory.
+ */
+template<typename Element>
+class WorkerImages {
+public:
+    /// The width and height of a tile in pixels.
+    static constexpr int TileSize = 32;
+
+    /// Allocates a cleared private copy of an image for each worker, unless the layout is unchanged.
+    void configure(int width, int height, int workerCount) {
+        if (width == m_width && height == m_height && workerCount == int(m_workers.size()))
+            return;
+
+        m_width = width;
+        m_height = height;
+        m_tilesX = (width + TileSize - 1) / TileSize;
+        m_tilesY = (height + TileSize - 1) / TileSize;
+
+        m_workers.clear();
+        m_workers.resize(workerCount);
+        for (auto &pixels : m_workers)
+            pixels.resize(size_t(tileCount()) * TileSize * TileSize, Element());
+    }
+
+    /// Returns how many workers copies have been prepared for.
+    int workerCount() const { return int(m_workers.size()); }
+
+    int tileCount() const { return m_tilesX * m_tilesY; }
+
+    /// Adds an element to the private copy of a worker (see `Image::splat`).
+    void splat(int worker, const Vector2f &p, const Element &e) {
+        const int x = std::min(int(p.x() * m_width), m_width - 1);
+        const int y = std::min(int(p.y() * m_height), m_height - 1);
+
+        const int tile = (y / TileSize) * m_tilesX + x / TileSize;
+        m_workers[worker][tileOffset(tile) + (y % TileSize) * TileSize + x % TileSize] += e;
+    }
+
+    /**
+     * @brief Adds one tile of all private copies to a target image and clears it.
+     *
+     * Different tiles can be reduced concurrently by different threads.
+     */
+    void reduce(Image<Element> &target, int tile) {
+        const int x0 = (tile % m_tilesX) * TileSize;
+        const int y0 = (tile / m_tilesX) * TileSize;
+        const int width = std::min(TileSize, m_width - x0);
+        const int height = std::min(TileSize, m_height - y0);
+
+        for (auto &pixels : m_workers) {
+            Element *const data = pixels.data() + tileOffset(tile);
+            for (int y = 0; y < height; ++y)
+                for (int x = 0; x < width; ++x)
+                    target.at(x0 + x, y0 + y) += data[y * TileSize + x];
+            std::fill(data, data + TileSize * TileSize, Element());
+        }
+    }
+
+    /// Clears the tiles of all workers.
+    void clear() {
+        for (auto &pixels : m_workers)
+            std::fill(pixels.begin(), pixels.end(), Element());
+    }
+
+private:
+    static size_t tileOffset(int tile) { return size_t(tile) * TileSize * TileSize; }
+
+    int m_width = 0, m_height = 0;
+    int m_tilesX = 0, m_tilesY = 0;
+    std::vector<std::vector<Element>> m_workers;
+};
+
 }
 
 #endif
@@ -13,6 +13,9 @@
 #include <hussar/core/thread.h>
 #include <hussar/core/logging.h>
 
+#include <radar/gridding.h>
+#include <radar/synthesis.h>
+
 #ifndef __CUDACC__
 #include <hussar/io/tev.h>
 #include <hussar/io/exr.h>
@@ -22,6 +25,19 @@ namespace hussar {
 
 class Integrator {
 public:
+    /// Denotes how contributions are accumulated in the simulated frame.
+    enum class FrameEngine {
+        /// Splats each contribution into the frame, approximating spectral leakage (see `radar::Frame::splat`).
+        Leakage,
+        /// Spreads contributions onto an oversampled grid that is transformed once per backend run
+        /// (see `radar::Gridder`). Only supported by the CPU backend.
+        Gridding,
+        /// Synthesizes the raw IF signal of each contribution (see `radar::Synthesizer`), i.e. the frame
+        /// will contain raw samples like those captured by a sensor (before any FFT is applied).
+        /// Only supported by the CPU backend.
+        Synthesis
+    };
+
     struct DebugElement {
         float distance;
         Complex contribution;
@@ -51,11 +67,52 @@ public:
             DebugElement d(*this);
             return d *= s;
         }
+
+        /// Adds another element, which is safe to do concurrently with other threads.
+        HUSSAR_CPU_GPU void addAtomic(const DebugElement &other) {
+#ifndef __CUDACC__
+            using radar::atomicAdd;
+#endif
+            atomicAdd(&distance, other.distance);
+            atomicAdd(&contribution.real(), other.contribution.real());
+            atomicAdd(&contribution.imag(), other.contribution.imag());
+            atomicAdd(&dphase, other.dphase);
+            atomicAdd(&invPdfs, other.invPdfs);
+            atomicAdd(&weight, other.weight);
+        }
     };
 
     using DebugImage = Image<DebugElement>;
 
+    /**
+     * @brief Records diagnostics over the primary sample space of the transmit antennas (see `getDebugImage`).
+     *
+     * The debug image is only allocated while this is enabled, and does not affect the simulated frame.
+     */
     bool produceDebugImage = false;
+    int debugImageWidth    = 1536; ///< the resolution of the debug image (allocated when a run starts)
+    int debugImageHeight   = 512;
+    bool perThreadFrames   = false; ///< CPU workers splat into private frames, which avoids atomic contention on hot bins
+    FrameEngine frameEngine = FrameEngine::Leakage;
+    /**
+     * @brief Splats contributions into the chirp dimension according to the velocity of their path.
+     *
+     * Opt-in, since fractional chirp coordinates spread each contribution over all chirps (and
+     * `FrameEngine::Gridding` grids the chirp dimension), which is wasted effort for static scenes.
+     */
+    bool simulateDoppler   = false;
+
+    /**
+     * @brief Requests that the error of the frame is estimated while sampling (see `BatchStatistics`),
+     * which is required for `targetRelativeError`.
+     */
+    bool estimateError     = false;
+    /// Stops sampling early once the relative error of the strongest bin falls below this value (0 disables).
+    Float targetRelativeError = 0;
+    /// The amount of batches the sample budget is split into for error estimation.
+    int errorBatches       = 32;
+    /// The minimum amount of batches before sampling may stop early, as fewer batches give unreliable estimates.
+    int minErrorBatches    = 8;
 
     HUSSAR_CPU_GPU void configureFrame(const radar::FrameConfig &config) {
         frame.configure(config);
@@ -63,8 +120,115 @@ public:
 
     HUSSAR_CPU_GPU void clearFrame() {
         frame.clear();
+        totalWeight = 0;
+#ifndef __CUDACC__
+        workerFrames.clear();
+        statistics.clear();
+        gridder.clear();
+        synthesizer.clear();
+        isFrameResolved = true;
+#endif
+    }
+
+    /**
+     * @brief Returns the simulated frame, normalized by the total weight of all samples taken so far.
+     *
+     * @note When `perThreadFrames` is enabled, this only includes samples of backend runs that have
+     * already completed. With `FrameEngine::Gridding` or `FrameEngine::Synthesis`, it only includes
+     * samples of batches that have already been resolved (see `resolveFrame`).
+     */
+    HUSSAR_CPU_GPU RadarFrame fetchFrame() {
+        return this->frame / Float(totalWeight);
+    }
+
+    /**
+     * @brief Returns the simulated frame along with the standard error of the real and imaginary parts
+     * of each of its bins (only available when `estimateError` or `targetRelativeError` is used).
+     */
+    RadarFrame fetchFrame(RadarFrame &standardError) {
+        standardError.configure(frame.config());
+        const Float scale = totalWeight > 0 ? Float(statistics.weight() / totalWeight) : 0;
+        for (size_t i = 0; i < standardError.sampleCount(); ++i)
+            standardError(i) = statistics.standardError(i, scale);
+        return fetchFrame();
+    }
+
+    /// Summarizes the estimated error of the simulated frame (see `estimateError`).
+    BatchStatistics::Estimate errorEstimate() const {
+        return statistics.estimate(frame, totalWeight);
     }
 
+#ifndef __CUDACC__
+    /**
+     * @brief Prepares the private frames of the workers (when `perThreadFrames` is enabled) and the
+     * gridder (when using `FrameEngine::Gridding`) before a CPU backend starts sampling.
+     */
+    void prepareWorkers(int workerCount) {
+        if (frameEngine == FrameEngine::Gridding) {
+            const bool gridded[radar::FrameConfig::NUM_COMPONENTS] = { simulateDoppler, true, false };
+            gridder.configure(frame.config(), gridded);
+        } else if (frameEngine == FrameEngine::Synthesis) {
+            synthesizer.configure(frame.config());
+        }
+
+        if (perThreadFrames)
+            workerFrames.configure(accumulationTarget().config(), workerCount);
+
+        if (produceDebugImage)
+            debugTiles.configure(debug.width(), debug.height(), workerCount);
+        else
+            debugTiles.configure(0, 0, 0);
+    }
+
+    /**
+     * @brief Called by every worker of a CPU backend before it starts sampling, which allows integrators
+     * to defer work to the workers instead of occupying additional threads (e.g. `PathTracer::asyncGuidingRebuild`).
+     */
+    void runBackgroundTasks() {}
+
+    /**
+     * @brief Adds the contributions accumulated by the workers to the shared frame once a CPU backend
+     * has finished sampling.
+     *
+     * Private frames of the workers are reduced in parallel over their bins (and private debug images
+     * over their tiles). When using `FrameEngine::Gridding` or `FrameEngine::Synthesis`, contributions
+     * remain in the gridder or synthesizer until the frame is read (see `resolveFrame`), since resolving
+     * is linear and its transforms are too expensive to repeat after every run.
+     *
+     * @param parallel Runs a task (taking a worker id) on all workers of the backend and waits for
+     * them to finish, e.g. `ThreadPool::parallel` or `ParallelSession::parallel`.
+     */
+    template<typename Parallel>
+    void reduceWorkers(Parallel &&parallel) {
+        if (perThreadFrames && workerFrames.workerCount() > 0) {
+            RadarFrame &target = accumulationTarget();
+
+            constexpr size_t ChunkSize = 4096;
+            const size_t sampleCount = target.sampleCount();
+            std::atomic<size_t> nextChunk(0);
+            parallel([&](int) {
+                size_t begin;
+                while ((begin = ChunkSize * nextChunk++) < sampleCount) {
+                    workerFrames.reduce(target, begin, std::min(begin + ChunkSize, sampleCount));
+                }
+            });
+
+            totalWeight = totalWeight + workerFrames.reduceTotalWeight();
+        }
+
+        if (debugTiles.workerCount() > 0) {
+            std::atomic<int> nextTile(0);
+            parallel([&](int) {
+                int tile;
+                while ((tile = nextTile++) < debugTiles.tileCount())
+                    debugTiles.reduce(debug, tile);
+            });
+        }
+
+        isFrameResolved = false;
+    }
+#endif
+
 #ifndef __CUDACC__
     DebugImage getDebugImage() {
         DebugImage result = debug;
@@ -98,66 +262,167 @@ public:
 #endif
     
 protected:
+    /**
+     * @brief Adds the contributions pending in the gridder or synthesizer to the frame, which is required
+     * before the frame is read while using `FrameEngine::Gridding` or `FrameEngine::Synthesis`.
+     *
+     * @warning Must not be called while a CPU backend is sampling.
+     */
+    void resolveFrame() {
+#ifndef __CUDACC__
+        if (isFrameResolved)
+            return;
+
+        if (frameEngine == FrameEngine::Gridding)
+            gridder.resolve(frame);
+        else if (frameEngine == FrameEngine::Synthesis)
+            synthesizer.resolve(frame);
+        isFrameResolved = true;
+#endif
+    }
+
     HUSSAR_CPU_GPU void setup() {
+#ifndef __CUDACC__
+        if (!produceDebugImage)
+            debug = DebugImage();
+        else if (debug.width() != debugImageWidth || debug.height() != debugImageHeight)
+            debug = DebugImage(debugImageWidth, debugImageHeight);
+        debugTiles.clear();
+#endif
         debug.clear();
         frame.clear();
     }
 
+    /// Accounts for the weight of a sample, which is used to normalize the frame.
+    HUSSAR_CPU_GPU void incrementTotalWeight(Float sampleWeight, int worker) {
+#ifdef __CUDACC__
+        atomicAdd(&totalWeight, static_cast<double>(sampleWeight));
+#else
+        if (perThreadFrames && worker < workerFrames.workerCount()) {
+            workerFrames.totalWeight(worker) += sampleWeight;
+            return;
+        }
+
+        /// @todo this is not elegant
+        // (and could be more efficient under GCC)
+        double oldV = totalWeight;
+        while (!totalWeight.compare_exchange_weak(oldV, oldV + sampleWeight));
+#endif
+    }
+
     /// Accounts for the phase shift that occurs when down-mixing the delayed RF signal.
     HUSSAR_CPU_GPU Complex measureRay(Float delta_t, const radar::RFConfig &rf) const {
         Complex phase = std::exp(Complex(0, 2*Pi * (rf.startFreq - delta_t * rf.freqSlope / 2) * delta_t));
         return phase;
     }
     
-    /// Records the contribution from a path from TX to RX in the frame buffer.
+    /**
+     * @brief Records the contribution from a path from TX to RX in the frame buffer.
+     *
+     * @param transmitter The index of the transmit antenna the path started at.
+     * @param receiver The index of the receive antenna the path ended at.
+     * @param delta_v The radial velocity of the path, i.e. half the rate at which its length changes
+     * (which matches the velocity of the object for monostatic paths with a single bounce).
+     * @param worker The index of the CPU worker that computed the contribution. Only used when
+     * `perThreadFrames` is enabled, in which case the contribution is recorded in the private
+     * frame of that worker.
+     * @tparam MayProduceDebugImage Allows callers to compile out the debug image when it is known to be disabled.
+     */
+    template<bool MayProduceDebugImage = true>
     HUSSAR_CPU_GPU void splat(
         const Scene &scene,
         const Vector2f &txDir, float txPdf,
-        int channel,
-        float delta_t, float dphase,
+        int transmitter, int receiver,
+        float delta_t, float delta_v, float dphase,
         const Complex &measurement,
-        Float weight
+        Float weight,
+        int worker
     ) {
-        if (!produceDebugImage) {
-            if (weight == 0 || (measurement.real() == 0 || measurement.imag() == 0))
-                return;
-        }
+        const bool isDebugging = MayProduceDebugImage && produceDebugImage;
+        const bool isZero = weight == 0 || (measurement.real() == 0 && measurement.imag() == 0);
+        if (isZero && !isDebugging)
+            return;
 
         delta_t += scene.rfConfig.antennaDelay;
 
+        if (!simulateDoppler)
+            delta_v = 0;
+
+        // with TDM-MIMO, each transmit antenna only sends every `transmitterCount`-th chirp
+        const int transmitterCount = scene.tx.size();
+
         RadarFrame::PIndex index;
         index.setTime(delta_t, scene.rfConfig, frame.config());
-        index.setVelocity(0.f, scene.rfConfig, frame.config());
-        index.channel = channel;
+        index.setVelocity(transmitterCount * delta_v, scene.rfConfig, frame.config());
+        index.channel = radar::FrameConfig::virtualChannel(transmitter, receiver, scene.rx.size());
         
         Complex contribution = measurement * measureRay(delta_t, scene.rfConfig);
+        if (transmitter > 0 && delta_v != 0) {
+            // accounts for the motion between the chirps of the first and this transmit antenna
+            const Float chirpShift = 2 * scene.rfConfig.startFreq * delta_v / radar::SPEED_OF_LIGHT / scene.rfConfig.chirpFrequency();
+            contribution *= radar::polar(Float(1), 2 * Pi * radar::modulo_one(transmitter * chirpShift));
+        }
         //contribution *= std::exp(-0.05f * delta_t * radar::SPEED_OF_LIGHT); /// @todo hack: simulate attenuation
-        frame.splat(index, weight * contribution);
-        
-        if (produceDebugImage) {
-            if (txPdf > 0) {
-                debug.splat(txDir, (DebugElement){
-                    .distance     = weight * radar::SPEED_OF_LIGHT * delta_t / txPdf,
-                    .contribution = weight * contribution, // has already been divided by txPdf
-                    .dphase       = weight * dphase / txPdf,
-                    .invPdfs      = 0,
-                    .weight       = 0
-                });
-            }
+
+        if (isDebugging && txPdf > 0) {
+            splatDebugElement(txDir, (DebugElement){
+                .distance     = weight * radar::SPEED_OF_LIGHT * delta_t / txPdf,
+                .contribution = weight * contribution, // has already been divided by txPdf
+                .dphase       = weight * dphase / txPdf,
+                .invPdfs      = 0,
+                .weight       = 0
+            }, worker);
         }
+
+        // the debug image must not change which contributions end up in the frame
+        if (isZero)
+            return;
+
+#ifndef __CUDACC__
+        const bool isPrivate = perThreadFrames && worker < workerFrames.workerCount();
+        if (frameEngine == FrameEngine::Gridding) {
+            if (isPrivate)
+                gridder.splat<false>(workerFrames.frame(worker), index, weight * contribution);
+            else
+                gridder.splat(index, weight * contribution);
+        } else if (frameEngine == FrameEngine::Synthesis) {
+            if (isPrivate)
+                synthesizer.splat<false>(workerFrames.frame(worker), index, weight * contribution);
+            else
+                synthesizer.splat(index, weight * contribution);
+        } else if (isPrivate) {
+            workerFrames.frame(worker).splat<16, false>(index, weight * contribution);
+        } else
+#endif
+        frame.splat(index, weight * contribution);
     }
 
     /// Splats additional information into the debug image.
-    HUSSAR_CPU_GPU void splatDebug(const Vector2f &txDir, float txPdf, Float weight) {
-        if (produceDebugImage) {
-            debug.splat(txDir, (DebugElement){
+    template<bool MayProduceDebugImage = true>
+    HUSSAR_CPU_GPU void splatDebug(const Vector2f &txDir, float txPdf, Float weight, int worker) {
+        if (MayProduceDebugImage && produceDebugImage) {
+            splatDebugElement(txDir, (DebugElement){
                 .distance     = 0,
                 .contribution = 0,
                 .dphase       = 0,
                 .invPdfs      = weight / txPdf,
                 .weight       = weight
-            });
+            }, worker);
+        }
+    }
+
+    /**
+     * @brief Adds an element to the debug image, either to the private tiles of a CPU worker (see
+     * `prepareWorkers`) or atomically to the shared image.
+     */
+    HUSSAR_CPU_GPU void splatDebugElement(const Vector2f &txDir, const DebugElement &element, int worker) {
+#ifndef __CUDACC__
+        if (worker < debugTiles.workerCount()) {
+            debugTiles.splat(worker, txDir, element);
+            return;
         }
+#endif
+        debug.at(txDir).addAtomic(element);
     }
 
     /// Reflects a ray in a perfectly specular manner.
@@ -168,7 +433,41 @@ protected:
     }
     
     RadarFrame frame;
-    DebugImage debug = DebugImage(1536, 512);
+    /// Only allocated while `produceDebugImage` is enabled (see `setup`).
+    DebugImage debug;
+    /// Private tiles of the debug image for the CPU workers.
+    WorkerImages<DebugElement> debugTiles;
+
+#ifdef __CUDACC__
+    double totalWeight;
+#else
+    std::atomic<double> totalWeight;
+#endif
+
+    /// Private frames of the CPU workers, used when `perThreadFrames` is enabled.
+    WorkerFrames workerFrames;
+
+    /// Estimates the error of the frame when `estimateError` or `targetRelativeError` is used.
+    BatchStatistics statistics;
+
+    /// Accumulates contributions when using `FrameEngine::Gridding`.
+    radar::Gridder<Allocator<Complex>> gridder;
+    /// Accumulates contributions when using `FrameEngine::Synthesis`.
+    radar::Synthesizer<Allocator<Complex>> synthesizer;
+    /// Whether the gridder or synthesizer holds no contributions that are missing from the frame.
+    bool isFrameResolved = true;
+
+private:
+#ifndef __CUDACC__
+    /// The frame that private frames of the workers are reduced into.
+    RadarFrame &accumulationTarget() {
+        switch (frameEngine) {
+        case FrameEngine::Gridding:  return gridder.grid();
+        case FrameEngine::Synthesis: return synthesizer.buffer();
+        default:                     return frame;
+        }
+    }
+#endif
 };
 
 }
@@ -31,6 +31,9 @@ public:
     /// The normal of the surface at the intersection.
     Vector3f n;
 
+    /// The velocity of the surface at the hit point (in m/s).
+    Vector3f velocity;
+
     /// The ray used for intersection.
     Ray ray;
     
@@ -53,6 +56,7 @@ public:
     HUSSAR_CPU_GPU void reset() {
         t = Infinity;
         tMax = Infinity;
+        velocity = Vector3f::Zero();
     }
 };
 
@@ -5,6 +5,7 @@
 #include <hussar/core/geometry.h>
 
 #include <vector>
+#include <algorithm>
 
 namespace hussar {
 
@@ -24,9 +25,67 @@ public:
         };
     };
 
+    /**
+     * @brief Describes the rigid motion of a group of triangles (in m/s and rad/s respectively).
+     *
+     * The motion is only used to compute the velocity of surfaces, i.e. the geometry itself is not
+     * moved. This is sufficient to simulate Doppler shifts, since objects barely move within a frame.
+     */
+    struct Motion {
+        Vector3f linearVelocity  = Vector3f::Zero();
+        Vector3f angularVelocity = Vector3f::Zero(); ///< axis times angular speed
+        Vector3f center          = Vector3f::Zero(); ///< the point the object rotates around
+
+        /// Returns the velocity of a point on the moving object.
+        HUSSAR_CPU_GPU Vector3f velocityAt(const Vector3f &p) const {
+            return linearVelocity + angularVelocity.cross(p - center);
+        }
+    };
+
+    /// Marks triangles that do not move.
+    static constexpr int Static = -1;
+
     std::vector<Vector3f> vertexBuffer;
     std::vector<IndexTriplet> indexBuffer;
 
+    std::vector<Motion> motionBuffer;
+    /// The index into `motionBuffer` for each triangle (triangles beyond its size are static).
+    std::vector<int> motionIndexBuffer;
+
+    /// Returns the number of triangles in this mesh.
+    size_t triangleCount() const { return indexBuffer.size(); }
+
+    /**
+     * @brief Attaches a motion to the triangles `[first, last)`, e.g. to all triangles of an object that
+     * has been added after calling `triangleCount()`.
+     *
+     * @returns the index of the motion in `motionBuffer`.
+     */
+    int addMotion(const Motion &motion, size_t first, size_t last) {
+        int index = (int)motionBuffer.size();
+        motionBuffer.push_back(motion);
+
+        if (motionIndexBuffer.size() < last)
+            motionIndexBuffer.resize(last, Static);
+        std::fill(motionIndexBuffer.begin() + first, motionIndexBuffer.begin() + last, index);
+        return index;
+    }
+
+    /// Attaches a motion to all triangles that have been added since the mesh had `first` triangles.
+    int addMotion(const Motion &motion, size_t first = 0) {
+        return addMotion(motion, first, triangleCount());
+    }
+
+    /// Returns the motion index of each triangle (padded with `Static`), or an empty list if nothing moves.
+    std::vector<int> motionIndices() const {
+        if (motionBuffer.empty())
+            return {};
+
+        std::vector<int> result = motionIndexBuffer;
+        result.resize(triangleCount(), Static);
+        return result;
+    }
+
     void addQuad(const Vector3f &a, const Vector3f &b, const Vector3f &c) {
         int i = (int)vertexBuffer.size();
 
@@ -0,0 +1,148 @@
+#ifndef HUSSAR_CORE_PIECEWISE_H
+#define HUSSAR_CORE_PIECEWISE_H
+
+#include <hussar/hussar.h>
+#include <hussar/core/allocator.h>
+#include <hussar/core/geometry.h>
+
+#include <vector>
+#include <algorithm>
+
+namespace hussar {
+
+/**
+ * @brief A piecewise-constant distribution on the unit square that is stored in flat arrays, so that
+ * sampling and evaluating it only takes a few contiguous loads.
+ *
+ * Samples are warped by inverting the marginal CDF of the first coordinate followed by the conditional
+ * CDF of the second coordinate. This warp is monotonic and therefore preserves the stratification of
+ * low-discrepancy samples.
+ */
+class PiecewiseConstant2D {
+public:
+    /**
+     * @brief Builds the distribution from (unnormalized) densities of a regular grid of cells.
+     *
+     * @param densities The density of cell `(i, j)` is found at `densities[i * resolution + j]`, where `i`
+     * denotes the cell along the first coordinate.
+     */
+    void build(const Float *densities, int resolution) {
+        m_resolution = resolution;
+        m_density.assign(densities, densities + resolution * resolution);
+        m_marginal.resize(resolution + 1);
+        m_conditional.resize(resolution * (resolution + 1));
+
+        double total = 0;
+        m_marginal[0] = 0;
+        for (int i = 0; i < resolution; ++i) {
+            Float *cdf = &m_conditional[i * (resolution + 1)];
+            const Float *row = &m_density[i * resolution];
+
+            double rowTotal = 0;
+            cdf[0] = 0;
+            for (int j = 0; j < resolution; ++j) {
+                rowTotal += row[j];
+                cdf[j + 1] = Float(rowTotal);
+            }
+            normalize(cdf, rowTotal);
+
+            total += rowTotal;
+            m_marginal[i + 1] = Float(total);
+        }
+        normalize(m_marginal.data(), total);
+
+        // densities with respect to the area of the unit square
+        const Float scale = total > 0 ? Float(resolution * resolution / total) : 1;
+        for (Float &density : m_density)
+            density = total > 0 ? density * scale : 1;
+    }
+
+    /// Releases the tables, after which the distribution is empty.
+    void clear() {
+        m_resolution = 0;
+        m_density.clear();
+        m_marginal.clear();
+        m_conditional.clear();
+    }
+
+    HUSSAR_CPU_GPU bool empty() const { return m_resolution == 0; }
+    HUSSAR_CPU_GPU int resolution() const { return m_resolution; }
+
+    /**
+     * @brief Warps a uniform sample according to the distribution.
+     *
+     * @returns the density of the warped sample.
+     */
+    HUSSAR_CPU_GPU Float sample(Vector2f &x) const {
+        const int i = warp(m_marginal.data(), x[0]);
+        const int j = warp(m_conditional.data() + i * (m_resolution + 1), x[1]);
+        return m_density.data()[i * m_resolution + j];
+    }
+
+    /// Inverts `sample`, i.e. returns the uniform sample that is warped to a given point.
+    HUSSAR_CPU_GPU Vector2f invert(const Vector2f &x) const {
+        const int i = std::min(int(x[0] * m_resolution), m_resolution - 1);
+        return Vector2f(
+            unwarp(m_marginal.data(), x[0]),
+            unwarp(m_conditional.data() + i * (m_resolution + 1), x[1])
+        );
+    }
+
+    /// Evaluates the density of the distribution.
+    HUSSAR_CPU_GPU Float pdf(const Vector2f &x) const {
+        const int i = std::min(int(x[0] * m_resolution), m_resolution - 1);
+        const int j = std::min(int(x[1] * m_resolution), m_resolution - 1);
+        return m_density.data()[i * m_resolution + j];
+    }
+
+private:
+    /// Normalizes a CDF to end at one, replacing CDFs without any mass by uniform ones.
+    void normalize(Float *cdf, double total) const {
+        for (int k = 1; k <= m_resolution; ++k)
+            cdf[k] = total > 0 ? Float(cdf[k] / total) : Float(k) / m_resolution;
+        cdf[m_resolution] = 1;
+    }
+
+    /**
+     * @brief Finds the cell of a CDF that contains a uniform value and remaps the value to the
+     * corresponding position in the unit interval.
+     */
+    HUSSAR_CPU_GPU int warp(const Float *cdf, Float &u) const {
+        // binary search for the last entry that does not exceed u (whose cell has non-zero mass)
+        int first = 0, count = m_resolution;
+        while (count > 0) {
+            const int step = count / 2;
+            if (cdf[first + step + 1] <= u) {
+                first += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+        const int cell = std::min(first, m_resolution - 1);
+
+        const Float width = cdf[cell + 1] - cdf[cell];
+        const Float offset = width > 0 ? (u - cdf[cell]) / width : Float(0.5);
+        u = (cell + std::min(std::max(offset, Float(0)), OneMinusEpsilon)) / m_resolution;
+        return cell;
+    }
+
+    /// Inverts `warp` for a position in the unit interval.
+    HUSSAR_CPU_GPU Float unwarp(const Float *cdf, Float x) const {
+        const int cell = std::min(int(x * m_resolution), m_resolution - 1);
+        const Float offset = x * m_resolution - cell;
+        return std::min(cdf[cell] + offset * (cdf[cell + 1] - cdf[cell]), OneMinusEpsilon);
+    }
+
+    int m_resolution = 0;
+    /// The normalized densities of the cells.
+    std::vector<Float, Allocator<Float>> m_density;
+    /// The CDF of the first coordinate.
+    std::vector<Float, Allocator<Float>> m_marginal;
+    /// The CDFs of the second coordinate, one per cell of the first coordinate.
+    std::vector<Float, Allocator<Float>> m_conditional;
+};
+
+}
+
+#endif
@@ -42,6 +42,17 @@ inline Vector3f UniformSampleSphere(const Vector2f &u) {
     return Vector3f(-r * std::sin(phi), y, -r * std::cos(phi));
 }
 
+/// Inverts `UniformSampleSphere`, i.e. returns the sample that is mapped to a given direction.
+inline Vector2f UniformSampleSphereInverse(const Vector3f &d) {
+    Float phi = std::atan2(-d.x(), -d.z());
+    if (phi < 0)
+        phi += 2 * Pi;
+    return Vector2f(
+        std::min(phi / (2 * Pi), OneMinusEpsilon),
+        std::min(std::max((d.y() + 1) / 2, Float(0)), OneMinusEpsilon)
+    );
+}
+
 inline Float UniformSpherePdf() {
     return Inv4Pi;
 }
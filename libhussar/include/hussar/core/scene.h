@@ -4,15 +4,68 @@
 #include <radar/radar.h>
 #include <hussar/hussar.h>
 #include <hussar/core/emitter.h> /// @todo hack!
+#include <hussar/core/logging.h>
+
+#include <initializer_list>
 
 namespace hussar {
 
+/**
+ * @brief A list of antennas with a fixed capacity, which allows scenes to be copied to the GPU as a whole.
+ */
+template<int Capacity>
+class AntennaArray {
+public:
+    HUSSAR_CPU_GPU AntennaArray() {}
+
+    AntennaArray(std::initializer_list<NFAntenna> antennas) {
+        for (const NFAntenna &antenna : antennas)
+            push_back(antenna);
+    }
+
+    void push_back(const NFAntenna &antenna) {
+        if (m_size >= Capacity)
+            Log(EError, "too many antennas (at most %d are supported)", Capacity);
+        m_antennas[m_size++] = antenna;
+    }
+
+    void clear() { m_size = 0; }
+
+    HUSSAR_CPU_GPU int size() const { return m_size; }
+    HUSSAR_CPU_GPU bool empty() const { return m_size == 0; }
+
+    HUSSAR_CPU_GPU NFAntenna &operator[](int i) { return m_antennas[i]; }
+    HUSSAR_CPU_GPU const NFAntenna &operator[](int i) const { return m_antennas[i]; }
+
+    HUSSAR_CPU_GPU NFAntenna *begin() { return m_antennas; }
+    HUSSAR_CPU_GPU NFAntenna *end() { return m_antennas + m_size; }
+    HUSSAR_CPU_GPU const NFAntenna *begin() const { return m_antennas; }
+    HUSSAR_CPU_GPU const NFAntenna *end() const { return m_antennas + m_size; }
+
+private:
+    NFAntenna m_antennas[Capacity];
+    int m_size = 0;
+};
+
 class Scene {
 public:
+    /// The maximum amount of receive antennas (e.g. four for the AWR1243).
+    static constexpr int MaxReceivers = 4;
+    /// The maximum amount of transmit antennas (e.g. three for the AWR1243).
+    static constexpr int MaxTransmitters = 3;
+
     radar::RFConfig rfConfig;
-    
-    NFAntenna rx;
-    NFAntenna tx;
+
+    /// The receive antennas, where the i-th antenna produces the i-th channel of the frame (per transmit antenna).
+    AntennaArray<MaxReceivers> rx;
+
+    /**
+     * @brief The transmit antennas, which take turns in sending chirps (time-division multiplexing).
+     *
+     * With multiple transmit antennas, the frame contains the channels of a virtual array
+     * (see `radar::FrameConfig::virtualChannel`).
+     */
+    AntennaArray<MaxTransmitters> tx;
 };
 
 }
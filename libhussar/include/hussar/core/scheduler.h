@@ -0,0 +1,151 @@
+#ifndef HUSSAR_CORE_SCHEDULER_H
+#define HUSSAR_CORE_SCHEDULER_H
+
+#include <hussar/hussar.h>
+
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <cstdint>
+
+namespace hussar {
+
+/**
+ * @brief Distributes sample indices among worker threads without any locks.
+ *
+ * The budget is split into one contiguous range per worker. Each range is stored in a single
+ * atomic word, so that its owner can take batches from the front while idle workers steal batches
+ * from the back, both using a single compare-and-swap.
+ * Batch sizes adapt to the remaining work: they start out large to keep scheduling overhead low,
+ * and shrink towards the end of a run so that all workers finish at roughly the same time.
+ */
+class SampleScheduler {
+public:
+    /// The smallest batch that will be handed out (unless less work remains).
+    long minBatch = 16;
+    /// The largest batch that will be handed out, which bounds the reaction time to interruptions.
+    long maxBatch = 16384;
+    /// Batches are chosen as this fraction of the remaining samples in a range.
+    long batchDivisor = 8;
+
+    /**
+     * @brief Distributes a new budget of samples `[0, budget)` among a given amount of workers.
+     *
+     * Budgets that do not fit into the 32-bit ranges of the workers are split into additional ranges,
+     * which are not owned by any worker and hence consumed by stealing.
+     *
+     * @warning Must not be called while workers are still fetching batches.
+     */
+    void reset(long budget, int workerCount) {
+        const long maxRange = long(UINT32_MAX);
+        const long rangeCount = std::max(long(workerCount), (budget + maxRange - 1) / maxRange);
+        if (rangeCount != m_rangeCount) {
+            m_ranges.reset(new Range[rangeCount]);
+            m_rangeCount = int(rangeCount);
+        }
+
+        const long quotient = budget / rangeCount;
+        const long remainder = budget % rangeCount;
+        for (long i = 0; i < rangeCount; ++i) {
+            Range &range = m_ranges[i];
+            range.base = i * quotient + std::min(i, remainder);
+
+            const long size = quotient + (i < remainder ? 1 : 0);
+            range.bounds.store(pack(0, uint32_t(size)), std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    /**
+     * @brief Fetches the next batch of sample indices `[begin, end)` for some worker.
+     *
+     * Workers first consume their own range and then start stealing from the range with the most
+     * remaining work.
+     *
+     * @returns false if no work is left.
+     */
+    bool next(int worker, long &begin, long &end) {
+        if (worker < m_rangeCount && takeFront(worker, begin, end))
+            return true;
+
+        while (true) {
+            int victim = -1;
+            uint32_t mostRemaining = 0;
+            for (int i = 0; i < m_rangeCount; ++i) {
+                uint64_t bounds = m_ranges[i].bounds.load(std::memory_order_relaxed);
+                uint32_t remaining = upper(bounds) - lower(bounds);
+                if (remaining > mostRemaining) {
+                    mostRemaining = remaining;
+                    victim = i;
+                }
+            }
+
+            if (victim < 0)
+                return false;
+
+            if (takeBack(victim, begin, end))
+                return true;
+        }
+    }
+
+private:
+    /// The range of a worker, aligned to cache lines to avoid false sharing.
+    struct alignas(64) Range {
+        /// The first sample index of this range.
+        long base;
+        /// Lower 32 bits: first remaining offset, upper 32 bits: end offset (relative to `base`).
+        std::atomic<uint64_t> bounds;
+    };
+
+    static uint64_t pack(uint32_t lower, uint32_t upper) { return uint64_t(upper) << 32 | lower; }
+    static uint32_t lower(uint64_t bounds) { return uint32_t(bounds); }
+    static uint32_t upper(uint64_t bounds) { return uint32_t(bounds >> 32); }
+
+    uint32_t batchSize(uint32_t remaining) const {
+        long batch = std::min(std::max(remaining / batchDivisor, minBatch), maxBatch);
+        return uint32_t(std::min<long>(batch, remaining));
+    }
+
+    /// Takes a batch from the front of a range (used by the owner of the range).
+    bool takeFront(int worker, long &begin, long &end) {
+        Range &range = m_ranges[worker];
+        uint64_t bounds = range.bounds.load(std::memory_order_relaxed);
+        while (true) {
+            uint32_t lo = lower(bounds), hi = upper(bounds);
+            if (lo >= hi)
+                return false;
+
+            uint32_t next = lo + batchSize(hi - lo);
+            if (range.bounds.compare_exchange_weak(bounds, pack(next, hi), std::memory_order_acquire)) {
+                begin = range.base + lo;
+                end   = range.base + next;
+                return true;
+            }
+        }
+    }
+
+    /// Takes a batch from the back of a range (used by workers that steal work).
+    bool takeBack(int victim, long &begin, long &end) {
+        Range &range = m_ranges[victim];
+        uint64_t bounds = range.bounds.load(std::memory_order_relaxed);
+        while (true) {
+            uint32_t lo = lower(bounds), hi = upper(bounds);
+            if (lo >= hi)
+                return false;
+
+            uint32_t next = hi - batchSize(hi - lo);
+            if (range.bounds.compare_exchange_weak(bounds, pack(lo, next), std::memory_order_acquire)) {
+                begin = range.base + next;
+                end   = range.base + hi;
+                return true;
+            }
+        }
+    }
+
+    std::unique_ptr<Range[]> m_ranges;
+    int m_rangeCount = 0;
+};
+
+}
+
+#endif
@@ -42,6 +42,11 @@ public:
         return singleton;
     }
 
+    /// Returns the number of worker threads in this pool.
+    int threadCount() const {
+        return int(m_threads.size());
+    }
+
     /// inspired by https://github.com/vit-vit/CTPL/blob/master/ctpl_stl.h
     template<typename F>
     auto push(F &&f) -> std::future<decltype(f(0))> {
@@ -98,6 +103,96 @@ protected:
     std::vector<std::thread> m_threads;
 };
 
+/**
+ * @brief Runs a sequence of parallel loops on a thread pool while dispatching only a single job per
+ * pool thread.
+ *
+ * The pool threads stay parked on a condition variable between loops, which avoids the cost of
+ * queueing new jobs (and allocating futures) for every loop, e.g. for every guiding iteration.
+ * The thread that calls `parallel` participates in each loop as an additional worker with the id
+ * `threadCount()`, so loops also make progress while pool threads are busy with other jobs.
+ * Tasks should therefore pull their work dynamically instead of relying on a fixed number of workers.
+ */
+class ParallelSession {
+public:
+    ParallelSession(ThreadPool &pool = ThreadPool::get()) {
+        m_futures.reserve(pool.threadCount());
+        for (int i = 0; i < pool.threadCount(); ++i)
+            m_futures.emplace_back(pool.push([this](int worker) { workerEntry(worker); }));
+        m_workerCount = pool.threadCount() + 1;
+    }
+
+    ParallelSession(const ParallelSession &) = delete;
+
+    ~ParallelSession() {
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_shouldStop = true;
+        }
+        m_wakeUp.notify_all();
+
+        for (auto &future : m_futures)
+            future.get();
+    }
+
+    /// Returns the number of worker ids that tasks can be invoked with (including the calling thread).
+    int workerCount() const { return m_workerCount; }
+
+    /// Runs a task on all workers and waits until every invocation has returned.
+    void parallel(const std::function<void (int)> &task) {
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_task = &task;
+            ++m_epoch;
+        }
+        m_wakeUp.notify_all();
+
+        task(m_workerCount - 1);
+
+        /// Workers that have not woken up yet will skip this loop
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_task = nullptr;
+        while (m_active > 0)
+            m_done.wait(lock);
+    }
+
+protected:
+    void workerEntry(int worker) {
+        unsigned int epoch = 0;
+
+        std::unique_lock<std::mutex> lock(m_lock);
+        while (true) {
+            while (!m_shouldStop && (!m_task || m_epoch == epoch))
+                m_wakeUp.wait(lock);
+
+            if (m_shouldStop)
+                return;
+
+            epoch = m_epoch;
+            const std::function<void (int)> *task = m_task;
+            ++m_active;
+
+            /// Do the task without holding any locks
+            lock.unlock();
+            (*task)(worker);
+            lock.lock();
+
+            if (--m_active == 0)
+                m_done.notify_all();
+        }
+    }
+
+    std::mutex m_lock;
+    std::condition_variable m_wakeUp;
+    std::condition_variable m_done;
+    bool m_shouldStop = false;
+    unsigned int m_epoch = 0;
+    int m_active = 0;
+    int m_workerCount;
+    const std::function<void (int)> *m_task = nullptr;
+    std::vector<std::future<void>> m_futures;
+};
+
 }
 
 #endif
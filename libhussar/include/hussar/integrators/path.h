@@ -7,11 +7,24 @@
 #include <hussar/core/sampler.h>
 #include <hussar/core/guiding.h>
 #include <hussar/core/allocator.h>
+#include <hussar/core/piecewise.h>
+#include <hussar/io/guidingcache.h>
 
 #include <hussar/samplers/halton.h> /// @todo hack!
 
 #include <guiding/structures/btree.h>
 #include <guiding/wrapper.h>
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <queue>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <future>
+#include <type_traits>
+
 namespace hussar {
 
 template<typename C, typename S = Float>
@@ -24,6 +37,12 @@ public:
 
     struct Settings {
         Float uniformProb = 0.5f;
+        /**
+         * The resolution of the table that the sampling distribution is compiled into after every rebuild
+         * (see `PiecewiseConstant2D`), which is faster to sample than the tree. 0 samples the tree directly.
+         * Only used for two-dimensional distributions that are sampled without additional parameters.
+         */
+        int tableResolution = 0;
         typename Distribution::Settings child;
     };
 
@@ -43,11 +62,18 @@ public:
         settings   = other.settings;
         m_sampling = other.m_sampling;
         m_training = other.m_training;
+        m_table    = other.m_table;
     }
 
     void reset() {
+#ifndef __CUDACC__
+        m_rebuild.reset();
+#endif
         m_training = Distribution();
         m_sampling = Distribution();
+        m_table.clear();
+        for (auto &worker : m_workers)
+            worker.records.clear();
     }
 
     template<typename ...Args>
@@ -58,23 +84,12 @@ public:
         Float pdf = 1 - settings.uniformProb; // guiding probability
         if (x[0] < settings.uniformProb) {
             x[0] /= settings.uniformProb;
-            pdf *= m_sampling.pdf(
-                settings.child,
-                x,
-                std::forward<Args>(params)...
-            );
+            pdf *= samplingPdf(x, std::forward<Args>(params)...);
         } else {
             x[0] -= settings.uniformProb;
             x[0] /= 1 - settings.uniformProb;
 
-            Float gpdf = 1;
-            m_sampling.sample(
-                settings.child,
-                gpdf,
-                x,
-                std::forward<Args>(params)...
-            );
-            pdf *= gpdf;
+            pdf *= sampleDistribution(x, std::forward<Args>(params)...);
         }
 
         pdf += settings.uniformProb;
@@ -86,12 +101,86 @@ public:
         if (settings.uniformProb == 1)
             return 1.f;
         
-        return settings.uniformProb + (1 - settings.uniformProb) * m_sampling.pdf(
-            settings.child,
-            std::forward<Args>(params)...
-        );
+        return settings.uniformProb + (1 - settings.uniformProb) * samplingPdf(std::forward<Args>(params)...);
     }
 
+    /**
+     * @brief Replaces the distribution by one that is learned from a density function.
+     *
+     * The density is evaluated at the centers of a regular grid, and each pass refines the tree further.
+     *
+     * @param density Returns the (unnormalized) density for a point of the domain.
+     */
+    template<typename Density>
+    void fit(Density &&density, int resolution = 64, int passes = 6) {
+#ifndef __CUDACC__
+        m_rebuild.reset();
+#endif
+        m_training = Distribution();
+        m_sampling = Distribution();
+
+        const Float cellWeight = Float(1) / Float(resolution * resolution);
+        for (int pass = 0; pass < passes; ++pass) {
+            for (int i = 0; i < resolution; ++i) {
+                for (int j = 0; j < resolution; ++j) {
+                    const Vector x((i + Float(0.5)) / resolution, (j + Float(0.5)) / resolution);
+                    m_training.splat(settings.child, Float(density(x)), AuxWrapper {}, cellWeight, x);
+                }
+            }
+
+            m_training.build(settings.child);
+            m_sampling = m_training;
+            m_training.refine(settings.child);
+        }
+        compile(m_sampling, settings, m_table);
+
+        if (onRebuild)
+            onRebuild();
+    }
+
+    /**
+     * @brief Replaces the distribution by a transformed and smoothed copy of its current sampling
+     * distribution, e.g. to seed a run with the result of a previous run.
+     *
+     * @param transform Maps points of the new domain to points of the previous one, and receives the absolute
+     * determinant of the Jacobian of this mapping as second argument (which is left at 1 by default).
+     * @param uniformWeight The weight of a uniform distribution that is blended into the result, which
+     * keeps regions that the previous distribution has missed reachable.
+     */
+    template<typename Transform>
+    void warmStart(Transform &&transform, Float uniformWeight) {
+        const Distribution previous = m_sampling;
+        fit([&](const Vector &x) {
+            Float jacobian = 1;
+            const Vector y = transform(x, jacobian);
+            return (1 - uniformWeight) * previous.pdf(settings.child, y) * jacobian + uniformWeight;
+        });
+    }
+
+    /**
+     * @brief Evaluates the sampling distribution (without the uniform component) at the centers of a
+     * regular grid, in the order expected by `fit` when looking up values by cell.
+     */
+    std::vector<Float> tabulate(int resolution) const {
+        return tabulate(m_sampling, settings, resolution);
+    }
+
+    static std::vector<Float> tabulate(const Distribution &sampling, const Settings &settings, int resolution) {
+        std::vector<Float> table(size_t(resolution) * resolution);
+        for (int i = 0; i < resolution; ++i) {
+            for (int j = 0; j < resolution; ++j) {
+                const Vector x((i + Float(0.5)) / resolution, (j + Float(0.5)) / resolution);
+                table[size_t(i) * resolution + j] = sampling.pdf(settings.child, x);
+            }
+        }
+        return table;
+    }
+
+    /**
+     * @brief Trains the distribution with a sample.
+     *
+     * @note This is not thread-safe, use `record` when splatting from multiple CPU workers.
+     */
     template<typename ...Args>
     HUSSAR_CPU_GPU void splat(const Sample &sample, const AuxWrapper &aux, Float weight, Args&&... params) {
         //if (settings.uniformProb == 1)
@@ -110,6 +199,96 @@ public:
         );
     }
 
+    /// Allocates private training records for the CPU workers of a backend (see `record`).
+    void prepareWorkers(int workerCount) {
+        if (int(m_workers.size()) != workerCount)
+            m_workers.resize(workerCount);
+    }
+
+    /**
+     * @brief Defers training with a sample to `merge`, which allows CPU workers to train without
+     * synchronization.
+     *
+     * Samples are recorded in the private buffer of each worker and replayed in the order of their
+     * indices, hence the trained distribution does not depend on the number of workers or on how
+     * samples have been distributed across them. Samples are splatted immediately on the GPU and
+     * for workers that have not been prepared.
+     *
+     * @param index A unique index of the sample, which determines the order of training.
+     */
+    HUSSAR_CPU_GPU void record(int worker, long index, const Sample &sample, const AuxWrapper &aux, Float weight, const Vector &x) {
+#ifndef __CUDACC__
+        if (worker < int(m_workers.size())) {
+            assert(std::isfinite(Float(sample)) && Float(sample) >= 0);
+            assert(std::isfinite(weight) && weight >= 0);
+            m_workers[worker].records.push_back({ index, sample, weight, x, aux });
+            return;
+        }
+#endif
+        splat(sample, aux, weight, x);
+    }
+
+#ifndef __CUDACC__
+    /**
+     * @brief Trains the distribution with all samples recorded by the workers.
+     *
+     * The buffers of the workers are sorted in parallel, then their samples are splatted in order (which is
+     * sequential, as the distribution does not support concurrent splats). `PathTracer::runBackend` bounds the
+     * amount of samples that are recorded between merges.
+     *
+     * @param parallel Runs a task (taking a worker id) on all workers of the backend and waits for
+     * them to finish (see `Integrator::reduceWorkers`).
+     */
+    template<typename Parallel>
+    void merge(Parallel &&parallel) {
+        if (m_rebuild) {
+            // the training distribution is being rebuilt, samples are merged once it has been installed
+            return;
+        }
+
+        size_t recordCount = 0;
+        for (auto &worker : m_workers)
+            recordCount += worker.records.size();
+        if (recordCount == 0)
+            return;
+
+        std::atomic<int> nextWorker(0);
+        parallel([&](int) {
+            int w;
+            while ((w = nextWorker++) < int(m_workers.size())) {
+                auto &records = m_workers[w].records;
+                std::sort(records.begin(), records.end(), [](const Record &a, const Record &b) {
+                    return a.index < b.index;
+                });
+            }
+        });
+
+        // k-way merge of the sorted buffers
+        using Head = std::pair<long, int>; // index of the next sample and the worker it belongs to
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+        std::vector<size_t> positions(m_workers.size(), 0);
+        for (int w = 0; w < int(m_workers.size()); ++w) {
+            if (!m_workers[w].records.empty())
+                heads.push({ m_workers[w].records.front().index, w });
+        }
+
+        while (!heads.empty()) {
+            const int w = heads.top().second;
+            heads.pop();
+
+            const auto &records = m_workers[w].records;
+            const Record &record = records[positions[w]++];
+            m_training.splat(settings.child, Float(record.sample), record.aux, record.weight, record.x);
+
+            if (positions[w] < records.size())
+                heads.push({ records[positions[w]].index, w });
+        }
+
+        for (auto &worker : m_workers)
+            worker.records.clear();
+    }
+#endif
+
     Distribution &training() { return m_training; }
     const Distribution &training() const { return m_training; }
 
@@ -117,17 +296,163 @@ public:
     const Distribution &sampling() const { return m_sampling; }
 
     void step() {
+#ifndef __CUDACC__
+        wait();
+        merge([](const std::function<void (int)> &task) { task(0); });
+#endif
         m_training.build(settings.child);
         m_sampling = m_training;
         m_training.refine(settings.child);
+        compile(m_sampling, settings, m_table);
 
         if (onRebuild)
             onRebuild();
     }
 
+#ifndef __CUDACC__
+    /**
+     * @brief Like `step`, but defers building the new distribution to the CPU workers of the backend.
+     *
+     * The rebuild is performed by the first worker that calls `runRebuild` (i.e. during the next run of the
+     * backend), while the other workers continue sampling with the current distribution. The new distribution
+     * is installed by `wait`, which runs the rebuild itself if no worker has claimed it. Samples recorded in
+     * the meantime (see `record`) are merged into the refined training distribution once it has been
+     * installed. Falls back to `step` when samples are splatted directly (i.e. no workers have been
+     * prepared), as these would be lost.
+     */
+    void stepAsync() {
+        if (m_workers.empty()) {
+            step();
+            return;
+        }
+
+        wait();
+        merge([](const std::function<void (int)> &task) { task(0); });
+
+        m_rebuild = std::make_unique<PendingRebuild>();
+        m_rebuild->task = std::packaged_task<Rebuild ()>([settings = settings, training = std::move(m_training)]() mutable {
+            training.build(settings.child);
+            Rebuild result { training, Distribution(), PiecewiseConstant2D() };
+            training.refine(settings.child);
+            result.training = std::move(training);
+            compile(result.sampling, settings, result.table);
+            return result;
+        });
+        m_training = Distribution();
+    }
+
+    /**
+     * @brief Performs a rebuild deferred by `stepAsync`, unless there is none or another worker has claimed it.
+     *
+     * @note Thread-safe, but must not be called while `wait` or `stepAsync` are running.
+     */
+    void runRebuild() {
+        if (m_rebuild && !m_rebuild->isClaimed.exchange(true))
+            m_rebuild->task();
+    }
+
+    /// Returns whether a rebuild deferred by `stepAsync` has not been installed yet.
+    bool isRebuilding() const { return bool(m_rebuild); }
+
+    /// Waits for a rebuild deferred by `stepAsync` to finish and installs its result.
+    void wait() {
+        if (!m_rebuild)
+            return;
+
+        runRebuild();
+        install();
+    }
+#endif
+
 private:
+    /// A sample whose training has been deferred (see `record`).
+    struct Record {
+        long index;
+        Sample sample;
+        Float weight;
+        Vector x;
+        AuxWrapper aux;
+    };
+
+    /// Aligned to cache lines so that appending records of different workers does not cause false sharing.
+    struct alignas(64) WorkerRecords {
+        std::vector<Record> records;
+    };
+
+    /// The distributions computed by a deferred rebuild (see `stepAsync`).
+    struct Rebuild {
+        Distribution sampling;
+        Distribution training;
+        PiecewiseConstant2D table;
+    };
+
+    /// A rebuild that waits for a worker to perform it (see `runRebuild`).
+    struct PendingRebuild {
+        std::packaged_task<Rebuild ()> task;
+        std::atomic<bool> isClaimed { false };
+    };
+
+    /// Whether sampling with some parameters can use the table of the distribution (see `Settings::tableResolution`).
+    template<typename ...Args>
+    static constexpr bool SupportsTable = sizeof...(Args) == 0 && std::is_same<Vector, Vector2f>::value;
+
+    template<typename ...Args>
+    HUSSAR_CPU_GPU Float samplingPdf(const Vector &x, Args&&... params) const {
+        if constexpr (SupportsTable<Args...>) {
+            if (!m_table.empty())
+                return m_table.pdf(x);
+        }
+
+        return m_sampling.pdf(settings.child, x, std::forward<Args>(params)...);
+    }
+
+    template<typename ...Args>
+    HUSSAR_CPU_GPU Float sampleDistribution(Vector &x, Args&&... params) {
+        if constexpr (SupportsTable<Args...>) {
+            if (!m_table.empty())
+                return m_table.sample(x);
+        }
+
+        Float pdf = 1;
+        m_sampling.sample(
+            settings.child,
+            pdf,
+            x,
+            std::forward<Args>(params)...
+        );
+        return pdf;
+    }
+
+    /// Compiles a sampling distribution into a table (see `Settings::tableResolution`).
+    static void compile(const Distribution &sampling, const Settings &settings, PiecewiseConstant2D &table) {
+        if (settings.tableResolution <= 0 || !SupportsTable<>) {
+            table.clear();
+            return;
+        }
+
+        const std::vector<Float> densities = tabulate(sampling, settings, settings.tableResolution);
+        table.build(densities.data(), settings.tableResolution);
+    }
+
+#ifndef __CUDACC__
+    void install() {
+        Rebuild result = m_rebuild->task.get_future().get();
+        m_rebuild.reset();
+        m_sampling = std::move(result.sampling);
+        m_training = std::move(result.training);
+        m_table = std::move(result.table);
+
+        if (onRebuild)
+            onRebuild();
+    }
+#endif
+
     Distribution m_sampling;
     Distribution m_training;
+    /// The sampling distribution compiled into a table (see `Settings::tableResolution`).
+    PiecewiseConstant2D m_table;
+    std::vector<WorkerRecords> m_workers;
+    std::unique_ptr<PendingRebuild> m_rebuild;
 };
 
 class PathTracer : public Integrator {
@@ -135,18 +460,216 @@ private:
     using GuidingTree = GuidingWrapper<
         guiding::BTree<2, guiding::Leaf<guiding::Empty>, guiding::Empty, Allocator>
     >;
-    GuidingTree guiding;
+    GuidingTree guiding[Scene::MaxTransmitters]; ///< one distribution of primary directions per transmit antenna
+
+    volatile Float currentSampleWeight = 1;
+    bool isFinalIteration = false;
+    /// The amount of transmit antennas of the current run, i.e. of guiding distributions in use.
+    int transmitterCount = 0;
+
+    void stepGuiding() {
+        for (int transmitter = 0; transmitter < transmitterCount; ++transmitter) {
+            GuidingTree &tree = guiding[transmitter];
+#ifndef __CUDACC__
+            if (asyncGuidingRebuild) {
+                tree.stepAsync();
+                continue;
+            }
+#endif
+            tree.step();
+        }
+    }
 
-    volatile Float currentSampleWeight;
-    bool isFinalIteration;
+    /// Waits for the deferred rebuilds of all guiding distributions (see `asyncGuidingRebuild`).
+    void waitGuiding() {
+#ifndef __CUDACC__
+        for (GuidingTree &tree : guiding)
+            tree.wait();
+#endif
+    }
 
-    HUSSAR_CPU_GPU void stepGuiding() {
-        guiding.step();
+    /// Returns whether any guiding distribution has a deferred rebuild that has not been installed yet.
+    bool isRebuildingGuiding() const {
+#ifndef __CUDACC__
+        for (const GuidingTree &tree : guiding)
+            if (tree.isRebuilding())
+                return true;
+#endif
+        return false;
+    }
+
+    /// Accumulates the frames of the guiding iterations (see `TrainingSchedule::combineIterations`).
+    RadarFrame combinedFrame;
+
+    /// The amount of batches the final iteration is split into (see `estimateError`).
+    int errorBatchCount() const {
+        return estimateError || targetRelativeError > 0 ? errorBatches : 1;
     }
 
-    HUSSAR_CPU_GPU void clearFrame() {
-        frame.clear();
-        totalWeight = 0;
+    /// Whether `guidingTransmitters` and the guiding distributions stem from a completed run (see `warmStartGuiding`).
+    bool hasGuidingHistory = false;
+    /// The transmit antennas of the last completed run.
+    AntennaArray<Scene::MaxTransmitters> guidingTransmitters;
+
+    /// The amount of cells along each axis when tabulating guiding distributions for `guidingCache`.
+    static constexpr int GuidingCacheResolution = 128;
+
+#ifndef __CUDACC__
+    /// Learns the guiding distributions from an entry of `guidingCache`, returning false if there is none.
+    bool loadGuiding(const Scene &scene, uint64_t key) {
+        GuidingCache::Entry entry;
+        if (!guidingCache->load(key, entry) || int(entry.densities.size()) != scene.tx.size())
+            return false;
+
+        // the tables exclude the uniform component, which is mixed in according to the current settings
+        if (entry.uniformProb != guiding[0].settings.uniformProb)
+            return false;
+
+        for (int transmitter = 0; transmitter < scene.tx.size(); ++transmitter) {
+            const std::vector<Float> &table = entry.densities[transmitter];
+            guiding[transmitter].fit([&](const Vector2f &x) {
+                const int i = std::min(int(x[0] * entry.resolution), entry.resolution - 1);
+                const int j = std::min(int(x[1] * entry.resolution), entry.resolution - 1);
+                return table[size_t(i) * entry.resolution + j];
+            }, entry.resolution);
+        }
+        return true;
+    }
+
+    /// Hashes the settings that affect the trained guiding distributions, which are part of the keys of `guidingCache`.
+    uint64_t guidingSettingsHash() const {
+        const radar::FrameConfig config = frame.config();
+        const GuidingTree::Settings &tree = guiding[0].settings;
+        const int integers[] = {
+            int(features() & ~FeatureDebugImage), maxDepth, tree.tableResolution,
+            config.chirpCount, config.samplesPerChirp, config.channelCount,
+            simulateDoppler, tree.child.child.secondMoment
+        };
+        const Float floats[] = {
+            filteringMin, filteringMax, filteringRadius,
+            tree.uniformProb, tree.child.splitThreshold
+        };
+
+        const uint64_t result = GuidingCache::hash(integers, sizeof(integers));
+        return GuidingCache::hash(floats, sizeof(floats), result);
+    }
+
+    /// Stores the guiding distributions of the transmit antennas in `guidingCache`.
+    void storeGuiding(const Scene &scene, uint64_t key) const {
+        GuidingCache::Entry entry;
+        entry.resolution = GuidingCacheResolution;
+        entry.uniformProb = guiding[0].settings.uniformProb;
+        for (int transmitter = 0; transmitter < scene.tx.size(); ++transmitter)
+            entry.densities.push_back(guiding[transmitter].tabulate(GuidingCacheResolution));
+        guidingCache->store(key, entry);
+    }
+#endif
+
+    /// Seeds the guiding distributions with those of the last run (see `warmStartGuiding`).
+    void seedGuiding(const Scene &scene) {
+        for (int transmitter = 0; transmitter < scene.tx.size(); ++transmitter) {
+            const NFAntenna &current = scene.tx[transmitter];
+            const NFAntenna &previous = guidingTransmitters[transmitter];
+
+            guiding[transmitter].warmStart([&](const Vector2f &x, Float &jacobian) {
+                return seedSample(current, previous, x, jacobian);
+            }, warmStartUniform);
+        }
+    }
+
+public:
+    /**
+     * @brief Maps a primary sample of a transmit antenna to the sample that produces the same direction for
+     * the antenna in its previous pose (see `warmStartGuiding`).
+     *
+     * @param jacobian Receives the absolute determinant of the Jacobian of the mapping, which converts densities
+     * over the previous samples into densities over the current ones. Non-uniform radiation patterns map samples
+     * to directions with varying density, hence it is given by the ratio of the densities of the direction under
+     * the previous and the current pose.
+     */
+    static Vector2f seedSample(const NFAntenna &current, const NFAntenna &previous, const Vector2f &x, Float &jacobian) {
+        // find the direction that the sample corresponds to in the previous frame of the antenna
+        Ray ray;
+        current.sample(x, ray);
+
+        const Float currentPdf = current.pdf(ray.d);
+        jacobian = currentPdf > 0 ? previous.pdf(ray.d) / currentPdf : 0;
+        return previous.invert(ray.d);
+    }
+
+    /// The strategies that primary directions are sampled with when guiding (see `PrimarySampling`).
+    enum PrimaryStrategy { PatternStrategy, GuidedStrategy, UniformStrategy, PrimaryStrategyCount };
+
+private:
+    /// Estimates of the second moments of the primary sampling strategies, accumulated by one worker.
+    struct alignas(64) PrimaryMoments {
+        double values[Scene::MaxTransmitters][PrimaryStrategyCount] = {};
+    };
+
+    /// The probabilities of selecting the primary sampling strategies, per transmit antenna.
+    Float primarySelection[Scene::MaxTransmitters][PrimaryStrategyCount];
+    /// One entry per CPU worker, or a single entry that is updated atomically on the GPU.
+    std::vector<PrimaryMoments, Allocator<PrimaryMoments>> primaryMoments;
+
+    /// Sets the probabilities of the primary sampling strategies to their initial values.
+    void resetPrimarySelection(int transmitter, bool isTrained) {
+        Float *selection = primarySelection[transmitter];
+        selection[PatternStrategy] = primarySampling.patternProb;
+        selection[UniformStrategy] = primarySampling.uniformProb;
+        selection[GuidedStrategy] = std::max(1 - selection[PatternStrategy] - selection[UniformStrategy], Float(0));
+
+        if (!isTrained) {
+            // an untrained guiding distribution is uniform, which merely duplicates the pattern strategy
+            const Float total = selection[PatternStrategy] + selection[UniformStrategy];
+            selection[PatternStrategy] = total > 0 ? selection[PatternStrategy] / total : 1;
+            selection[UniformStrategy] = total > 0 ? selection[UniformStrategy] / total : 0;
+            selection[GuidedStrategy] = 0;
+        }
+    }
+
+    void clearPrimaryMoments() {
+        for (PrimaryMoments &moments : primaryMoments)
+            moments = PrimaryMoments();
+    }
+
+    /**
+     * @brief Adapts the probabilities of the primary sampling strategies to the samples of the last training
+     * iteration, in inverse proportion to the second moments of the strategies (see `PrimarySampling`).
+     */
+    void adaptPrimarySelection(int transmitterCount) {
+        for (int transmitter = 0; transmitter < transmitterCount; ++transmitter) {
+            Float *selection = primarySelection[transmitter];
+
+            double moments[PrimaryStrategyCount] = {};
+            for (const PrimaryMoments &worker : primaryMoments)
+                for (int strategy = 0; strategy < PrimaryStrategyCount; ++strategy)
+                    moments[strategy] += worker.values[transmitter][strategy];
+
+            if (!primarySampling.adaptive || selection[GuidedStrategy] == 0 ||
+                !(moments[PatternStrategy] > 0 && moments[GuidedStrategy] > 0 && moments[UniformStrategy] > 0)) {
+                // the guiding distribution has only now been trained (or there was nothing to learn from)
+                resetPrimarySelection(transmitter, true);
+                continue;
+            }
+
+            double total = 0;
+            for (int strategy = 0; strategy < PrimaryStrategyCount; ++strategy)
+                total += 1 / moments[strategy];
+
+            Float target[PrimaryStrategyCount];
+            target[PatternStrategy] = std::max(Float(1 / moments[PatternStrategy] / total), primarySampling.minProb);
+            target[UniformStrategy] = std::max(Float(1 / moments[UniformStrategy] / total), primarySampling.minProb);
+            target[GuidedStrategy] = std::max(1 - target[PatternStrategy] - target[UniformStrategy], Float(0));
+
+            // the estimates are noisy, hence the probabilities only move halfway towards their targets
+            Float sum = 0;
+            for (int strategy = 0; strategy < PrimaryStrategyCount; ++strategy)
+                sum += selection[strategy] = (selection[strategy] + target[strategy]) / 2;
+            for (int strategy = 0; strategy < PrimaryStrategyCount; ++strategy)
+                selection[strategy] /= sum;
+        }
+
+        clearPrimaryMoments();
     }
 
 public:
@@ -156,7 +679,15 @@ public:
     bool useGeometricalOptics = true;  ///< should always be true!
     bool poDiffraction        = !true; ///< ignore visibility for next event estimation
     bool doGuiding            = true;  ///< improves sampling significantly
-    bool clearBeforeIteration = true; ///< requests that each render interation in guiding starts with a fresh frame
+    /**
+     * @brief Rebuilds guiding distributions on one of the CPU workers while the others start the next training
+     * iteration with the previous distributions, which are replaced once the first run of the backend in that
+     * iteration has finished (see `runBackgroundTasks`). This point does not depend on timing, hence runs remain
+     * reproducible, but samples of that run do not benefit from the new distributions. Iterations that are not
+     * split into batches (see `errorBatches` and `TrainingSchedule::varianceBatches`) are split for this purpose,
+     * with the first run taking `1 / RebuildOverlapDivisor` of their samples.
+     */
+    bool asyncGuidingRebuild  = false;
 
     bool correctPhase         = !true; ///< use with filteringSphere to simulate SBR behavior
     bool filterGuiding        = true; ///< helps with small filtering spheres
@@ -168,8 +699,215 @@ public:
 
     Float filteringRadius     = correctPhase ? 0.5 : 160; ///< in wavelengths, used when filteringSphere = true
 
+    bool wavefront            = false; ///< CPU backend traces batches of paths with ray packets (see sampleWavefront)
+
+    /// The maximum value of `heroFrequencies`.
+    static constexpr int MaxHeroFrequencies = 32;
+    /**
+     * @brief The amount of frequencies each connection to a receiver is evaluated for when using geometrical
+     * optics (1 disables), spread evenly across the bandwidth of the chirp starting at the frequency of the path.
+     *
+     * The geometry of such paths does not depend on their frequency, hence one traced path yields contributions
+     * for several frequencies, which only differ in the decay of re-radiated fields and in filtering. Their
+     * average is splatted once, since the bin and phase of a contribution only depend on the length of its path.
+     */
+    int heroFrequencies       = 1;
+
+    /**
+     * @brief The options that the sampling code is specialized for at compile time (see `dispatch`).
+     *
+     * Combinations of options that are not specialized fall back to checking the options at runtime.
+     */
+    enum Feature : unsigned {
+        FeatureGeometricalOptics = 1 << 0, ///< see `useGeometricalOptics`
+        FeaturePODiffraction     = 1 << 1, ///< see `poDiffraction`
+        FeatureGuiding           = 1 << 2, ///< see `doGuiding`
+        FeatureCorrectPhase      = 1 << 3, ///< see `correctPhase`
+        FeatureFilterGuiding     = 1 << 4, ///< see `filterGuiding`
+        FeatureFiltering         = 1 << 5, ///< see `doFiltering`
+        FeatureFilteringSphere   = 1 << 6, ///< see `filteringSphere`
+        FeatureOnlyIndirect      = 1 << 7, ///< see `onlyIndirect`
+        FeatureDebugImage        = 1 << 8  ///< see `produceDebugImage`
+    };
+    static constexpr int FeatureCount = 9;
+
+    /// The options of the path tracer in its default configuration.
+    static constexpr unsigned DefaultFeatures =
+        FeatureGeometricalOptics | FeatureGuiding | FeatureFilterGuiding |
+        FeatureFiltering | FeatureFilteringSphere | FeatureOnlyIndirect;
+    /// The options of the path tracer in its default configuration, but without guiding.
+    static constexpr unsigned UnguidedFeatures = DefaultFeatures & ~FeatureGuiding;
+    /// Denotes the variant of the sampling code that checks all options at runtime.
+    static constexpr unsigned DynamicFeatures = ~0u;
+
+    /// Returns whether an option is enabled.
+    HUSSAR_CPU_GPU bool flag(Feature feature) const {
+        switch (feature) {
+        case FeatureGeometricalOptics: return useGeometricalOptics;
+        case FeaturePODiffraction:     return poDiffraction;
+        case FeatureGuiding:           return doGuiding;
+        case FeatureCorrectPhase:      return correctPhase;
+        case FeatureFilterGuiding:     return filterGuiding;
+        case FeatureFiltering:         return doFiltering;
+        case FeatureFilteringSphere:   return filteringSphere;
+        case FeatureOnlyIndirect:      return onlyIndirect;
+        case FeatureDebugImage:        return produceDebugImage;
+        default:                       return false;
+        }
+    }
+
+    /// Returns the set of enabled options.
+    HUSSAR_CPU_GPU unsigned features() const {
+        unsigned result = 0;
+        for (int bit = 0; bit < FeatureCount; ++bit) {
+            if (flag(Feature(1u << bit)))
+                result |= 1u << bit;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Describes how the sample budget of a run is split into guiding iterations.
+     *
+     * Training iterations grow geometrically until the remaining budget (or time) only suffices for a final
+     * iteration that is at least twice as large, or (if requested) until training stops reducing the variance of
+     * the samples.
+     */
+    struct TrainingSchedule {
+        long initialSamples = 16384; ///< the amount of samples of the first iteration
+        Float growth = 2;            ///< the factor by which the amount of samples grows with every iteration
+        /**
+         * Ends training once an iteration reduces the variance per sample by less than this fraction (0 disables).
+         * Opt-in, as estimating the variance splits each training iteration into `varianceBatches` runs of the
+         * backend, and ending training early changes the frame of a run.
+         */
+        Float minVarianceReduction = 0;
+        /**
+         * Combines the frames of all iterations weighted by the inverse of their variance, instead of only using
+         * the final iteration (whose variance is assumed to be that of the last training iteration). Opt-in, as
+         * this continues the sample sequence across iterations and hence changes the frame of a run.
+         */
+        bool combineIterations = false;
+        /// The amount of batches each training iteration is split into to estimate its variance.
+        int varianceBatches = 8;
+        /// Limits the duration of a run (in seconds, 0 disables), in which case the sample budget serves as an upper bound.
+        double timeBudget = 0;
+    };
+
+    TrainingSchedule schedule;
+
+    /// Tracks the variance of the training iterations of a run (see `TrainingSchedule`).
+    struct TrainingProgress {
+        double referenceVariance = 0; ///< the variance per sample of the first iteration
+        double previousVariance = 0;  ///< the variance per sample of the previous iteration
+        Float iterationWeight = 1;    ///< the weight of the samples of the last iteration in the combination
+        /// Whether the last iteration reduced the variance by less than `TrainingSchedule::minVarianceReduction`.
+        bool hasConverged = false;
+
+        /**
+         * @brief Records the variance per sample of a completed training iteration.
+         *
+         * @returns the weight of the samples of the iteration in the combination of iterations, which is
+         * inversely proportional to its variance (relative to the first iteration to keep weights moderate),
+         * or 0 if the iteration is not combined (see `TrainingSchedule::combineIterations`).
+         */
+        Float record(const TrainingSchedule &schedule, double variance) {
+            hasConverged = previousVariance > 0 && variance > (1 - schedule.minVarianceReduction) * previousVariance;
+            previousVariance = variance;
+
+            if (!schedule.combineIterations || !(variance > 0))
+                return 0;
+
+            if (referenceVariance == 0)
+                referenceVariance = variance;
+            iterationWeight = Float(referenceVariance / variance);
+            return iterationWeight;
+        }
+    };
+
+    /**
+     * @brief Seeds the guiding distributions of a run with those of the previous run (rotated into the new
+     * frames of the transmit antennas) instead of learning them from scratch, which suits sweeps over
+     * consecutive poses of the antennas.
+     */
+    bool warmStartGuiding     = false;
+    Float warmStartUniform    = 0.25f; ///< the weight of the uniform distribution blended into seeded distributions
+    int warmStartIterations   = 1; ///< the amount of training iterations that follow a warm start
+
+    /// Skips training when the guiding distributions for a scene have been cached by an earlier run (optional).
+    GuidingCache *guidingCache = nullptr;
+
+    /// How the contributions of the primary sampling strategies are weighted (see `PrimarySampling`).
+    enum class MISHeuristic {
+        Balance,
+        Power ///< with an exponent of two
+    };
+
+    /**
+     * @brief Describes how primary directions are sampled when guiding, namely by one-sample multiple importance
+     * sampling of the radiation pattern of the transmit antenna, the guiding distribution and the uniform sphere.
+     *
+     * The guiding distribution is only used once it has been trained. From then on, the probabilities of the
+     * strategies start at their initial values and are adapted after every training iteration in inverse
+     * proportion to the second moments of the strategies, which are estimated from the samples of the iteration.
+     */
+    struct PrimarySampling {
+        MISHeuristic heuristic = MISHeuristic::Balance;
+        Float patternProb = 0.05f; ///< the initial probability of sampling the radiation pattern
+        Float uniformProb = 0.05f; ///< the initial probability of sampling the uniform sphere
+        /// The lower bound for adapted probabilities of the pattern and uniform strategies, which keeps sampling robust.
+        Float minProb = 0.02f;
+        bool adaptive = true;      ///< adapts the probabilities after every training iteration
+    };
+
+    PrimarySampling primarySampling;
+
+#ifndef __CUDACC__
+    /// Additionally prepares the workers to record guiding samples without synchronization.
+    void prepareWorkers(int workerCount) {
+        Integrator::prepareWorkers(workerCount);
+
+        for (int transmitter = 0; transmitter < Scene::MaxTransmitters; ++transmitter)
+            guiding[transmitter].prepareWorkers(doGuiding && transmitter < transmitterCount ? workerCount : 0);
+
+        // the moments accumulate across the batches of a training iteration
+        if (doGuiding && int(primaryMoments.size()) != workerCount) {
+            primaryMoments.resize(workerCount);
+            clearPrimaryMoments();
+        }
+    }
+
+    /// Performs the rebuilds of guiding distributions that have been deferred to the workers (see `asyncGuidingRebuild`).
+    void runBackgroundTasks() {
+        for (int transmitter = 0; transmitter < transmitterCount; ++transmitter)
+            guiding[transmitter].runRebuild();
+    }
+
+    /**
+     * @brief Additionally installs rebuilt guiding distributions (see `asyncGuidingRebuild`) and trains them
+     * with the samples recorded by the workers.
+     */
+    template<typename Parallel>
+    void reduceWorkers(Parallel &&parallel) {
+        Integrator::reduceWorkers(parallel);
+
+        for (int transmitter = 0; transmitter < transmitterCount; ++transmitter) {
+            guiding[transmitter].wait();
+            guiding[transmitter].merge(parallel);
+        }
+    }
+#endif
+
     template<typename Backend>
     void run(Backend &backend, const Scene &scene, long samples, bool *interruptFlag = nullptr) {
+        // every path starts at one of the transmit antennas and ends in one channel per receive antenna
+        if (scene.tx.empty())
+            Log(EError, "the scene needs at least one transmit antenna");
+        if (frame.config().channelCount < scene.tx.size() * scene.rx.size())
+            Log(EError, "the frame has %d channels, but %d transmit and %d receive antennas require %d",
+                frame.config().channelCount, scene.tx.size(), scene.rx.size(), scene.tx.size() * scene.rx.size());
+        transmitterCount = scene.tx.size();
+
         setup();
         clearFrame();
 
@@ -177,302 +915,968 @@ public:
         currentSampleWeight = 1.f;
 
         if (!doGuiding) {
-            backend.run(scene, samples, interruptFlag);
+            runBatches(backend, scene, samples, interruptFlag, errorBatchCount(), true);
+            return;
+        }
+
+        /// keep the workers of the backend dispatched across all guiding iterations
+        [[maybe_unused]] auto session = backend.session();
+
+        if (primaryMoments.empty())
+            primaryMoments.resize(1);
+        clearPrimaryMoments();
+
+#ifndef __CUDACC__
+        const uint64_t cacheKey = guidingCache ? guidingCache->key(scene, guidingSettingsHash()) : 0;
+        if (guidingCache && loadGuiding(scene, cacheKey)) {
+            // the cached distributions are fully trained, hence all samples contribute to the frame
+            for (int transmitter = 0; transmitter < scene.tx.size(); ++transmitter)
+                resetPrimarySelection(transmitter, true);
+            hasGuidingHistory = false;
+            isFinalIteration = true;
+            if (runBatches(backend, scene, samples, interruptFlag, errorBatchCount(), true)) {
+                guidingTransmitters = scene.tx;
+                hasGuidingHistory = true;
+            }
             return;
         }
+#endif
 
-        guiding.reset();
+        const bool isWarmStart = warmStartGuiding && hasGuidingHistory && guidingTransmitters.size() == scene.tx.size();
+        if (isWarmStart) {
+            seedGuiding(scene);
+        } else {
+            for (int transmitter = 0; transmitter < transmitterCount; ++transmitter)
+                guiding[transmitter].reset();
+        }
+        for (int transmitter = 0; transmitter < scene.tx.size(); ++transmitter)
+            resetPrimarySelection(transmitter, isWarmStart);
         isFinalIteration = false;
-        
-        long milestone = 16384;
+        hasGuidingHistory = false;
+        int iteration = 0;
+
+        const auto startTime = std::chrono::steady_clock::now();
+        const bool tracksVariance = schedule.combineIterations || schedule.minVarianceReduction > 0;
+        TrainingProgress progress;
+        double combinedWeight = 0;
+        if (schedule.combineIterations) {
+            combinedFrame.configure(frame.config());
+            combinedFrame.clear();
+        }
+
+        long milestone = schedule.initialSamples;
         long remainingSamples = samples;
+        long takenSamples = 0;
 
         while (true) {
             milestone = std::min(milestone, remainingSamples);
-            //std::cout << "iteration (" << milestone << " samples)" << std::endl;
 
-            backend.run(scene, milestone, interruptFlag);
-            if (interruptFlag && *interruptFlag)
+            if (milestone == remainingSamples) {
+                // the last iteration determines the frame, hence its error is estimated (if requested)
+                if (!runBatches(backend, scene, milestone, interruptFlag, errorBatchCount(), true))
+                    return;
+                break;
+            }
+
+            if (!runBatches(backend, scene, milestone, interruptFlag, tracksVariance ? schedule.varianceBatches : 1, false))
                 return;
-            
-            sampleIndexOffset += milestone;
 
+            takenSamples += milestone;
             remainingSamples -= milestone;
-            if (remainingSamples == 0)
-                break;
-        
-            milestone *= 2;
 
-            if (remainingSamples < milestone * 2) {
-                //std::cout << "  final iteration" << std::endl;
+            bool hasConverged = false;
+            if (tracksVariance && statistics.batchCount() >= 2) {
+                const double variance = statistics.totalVariance() * statistics.weight();
+                const Float iterationWeight = progress.record(schedule, variance);
+                hasConverged = progress.hasConverged;
+
+                if (iterationWeight > 0) {
+                    for (size_t i = 0; i < frame.sampleCount(); ++i)
+                        combinedFrame(i) += iterationWeight * frame(i);
+                    combinedWeight += iterationWeight * totalWeight;
+                }
+            }
+
+            if (schedule.timeBudget > 0) {
+                // limit the remaining budget to the samples we can afford in the remaining time
+                const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                const double rate = takenSamples / std::max(elapsed, 1e-6);
+                remainingSamples = std::min(remainingSamples, long(rate * std::max(schedule.timeBudget - elapsed, 0.0)));
+                if (remainingSamples <= 0) {
+                    if (combinedWeight > 0) {
+                        frame = combinedFrame;
+                        totalWeight = combinedWeight;
+                    }
+                    break;
+                }
+            }
+
+            milestone = long(milestone * schedule.growth);
+
+            // seeded distributions only need to adapt, hence most of the budget goes to the final iteration
+            if (remainingSamples < milestone * 2 || hasConverged || (isWarmStart && ++iteration >= warmStartIterations)) {
                 isFinalIteration = true;
                 milestone = remainingSamples;
             }
 
-            if (clearBeforeIteration) {
-                clearFrame();
-                debug.clear();
+            clearFrame();
+            debug.clear();
+            if (!schedule.combineIterations) {
+                // combined iterations need to continue the sample sequence to remain independent
                 sampleIndexOffset = 0;
-            } else {
-                // new samples are giving more weight in our simulated frame, because they have
-                // better quality (i.e. less noise) since guiding has been trained longer
-                currentSampleWeight = 10 * currentSampleWeight;
             }
 
+            adaptPrimarySelection(scene.tx.size());
             stepGuiding();
+
+            if (isFinalIteration && combinedWeight > 0) {
+                // the final iteration continues the combination of the training iterations,
+                // with its samples weighted according to the variance of the last training iteration
+                frame = combinedFrame;
+                totalWeight = combinedWeight;
+                currentSampleWeight = progress.iterationWeight;
+            }
         }
+
+        waitGuiding();
+        guidingTransmitters = scene.tx;
+        hasGuidingHistory = true;
+
+#ifndef __CUDACC__
+        if (guidingCache)
+            storeGuiding(scene, cacheKey);
+#endif
+    }
+
+    /**
+     * @brief Takes samples in batches of equal size to estimate the error of the frame while sampling
+     * (see `statistics`).
+     *
+     * @param batchCount The amount of batches, where a single batch skips error estimation.
+     * @param mayStop Whether sampling stops early once `targetRelativeError` has been reached.
+     * @returns false if sampling has been interrupted.
+     */
+    template<typename Backend>
+    bool runBatches(Backend &backend, const Scene &scene, long samples, bool *interruptFlag, int batchCount, bool mayStop) {
+        if (batchCount <= 1) {
+            // deferred rebuilds overlap a short first run, after which the remaining samples use the new distributions
+            const long overlapped = isRebuildingGuiding() ? samples / RebuildOverlapDivisor : 0;
+            bool isComplete = overlapped == 0 || runBackend(backend, scene, overlapped, interruptFlag);
+            waitGuiding();
+            if (isComplete)
+                isComplete = runBackend(backend, scene, samples - overlapped, interruptFlag);
+            resolveFrame();
+            return isComplete;
+        }
+
+        statistics.reset(frame);
+
+        batchCount = int(std::min<long>(batchCount, samples));
+        for (long batch = 0; batch < batchCount; ++batch) {
+            // distributes the remainder of the division across the first batches
+            const long batchSize = samples / batchCount + (batch < samples % batchCount ? 1 : 0);
+            const double previousWeight = totalWeight;
+
+            const bool isComplete = runBackend(backend, scene, batchSize, interruptFlag);
+            resolveFrame();
+            if (!isComplete)
+                return false;
+
+            statistics.record(frame, totalWeight - previousWeight);
+
+            if (mayStop && targetRelativeError > 0 && statistics.batchCount() >= minErrorBatches &&
+                errorEstimate().peakRelativeError < targetRelativeError) {
+                Log(EDebug, "converged after %ld of %d batches", batch + 1, batchCount);
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    /// The fraction of an unbatched run that samples with the previous distributions while they are rebuilt (see `runBatches`).
+    static constexpr long RebuildOverlapDivisor = 32;
+
+    /// The maximum amount of samples per run of the backend while training guiding (see `runBackend`).
+    static constexpr long MaxRecordedSamples = 1 << 20;
+
+    /**
+     * @brief Runs the backend for a range of samples that continues the sample sequence.
+     *
+     * While guiding is trained, the range is split into runs of at most `MaxRecordedSamples` samples,
+     * which bounds the memory of the samples recorded by the workers between merges (see `GuidingWrapper::record`).
+     * As samples are merged in the order of their indices, this does not affect the trained distributions.
+     *
+     * @returns false if sampling has been interrupted.
+     */
+    template<typename Backend>
+    bool runBackend(Backend &backend, const Scene &scene, long samples, bool *interruptFlag) {
+        const long chunkSize = doGuiding && !isFinalIteration ? MaxRecordedSamples : samples;
+        for (long offset = 0; offset < samples; offset += chunkSize) {
+            const long size = std::min(chunkSize, samples - offset);
+            backend.run(scene, size, interruptFlag);
+            if (interruptFlag && *interruptFlag)
+                return false;
+
+            sampleIndexOffset += size;
+        }
+        return true;
     }
 
     HUSSAR_CPU_GPU void setup() {
         Integrator::setup();
 
-        guiding.settings.uniformProb = 0.1f;
-        guiding.settings.child.splitThreshold = 0.005f;
-        //guiding.settings.child.filtering = guiding::TreeFilter::EBox;
-        guiding.settings.child.child.secondMoment = true;
+        for (GuidingTree &tree : guiding) {
+            tree.settings.uniformProb = 0; // other strategies are mixed in by samplePrimary
+            tree.settings.tableResolution = 256;
+            tree.settings.child.splitThreshold = 0.005f;
+            //tree.settings.child.filtering = guiding::TreeFilter::EBox;
+            tree.settings.child.child.secondMoment = true;
+        }
     }
 
+    /**
+     * @brief Traces a single path and splats its contributions.
+     *
+     * @param worker The index of the CPU worker executing this sample (see `Integrator::perThreadFrames`).
+     */
     template<typename RT>
-    HUSSAR_CPU_GPU void sample(const Scene &scene, const RT &rt, long index) {
-        HaltonSampler sampler;
-        sampler.setSampleIndex(sampleIndexOffset + index);
+    HUSSAR_CPU_GPU void sample(const Scene &scene, const RT &rt, long index, int worker = 0) {
+        dispatch([&](auto config) {
+            samplePath<decltype(config)::value>(scene, rt, index, worker);
+        });
+    }
 
-        float maxDist = scene.rfConfig.adcRate / scene.rfConfig.freqSlope * radar::SPEED_OF_LIGHT; /// @todo not elegant
+    /**
+     * @brief Like `sample`, but uses a given variant of the sampling code (see `variant`), which allows
+     * GPU backends to compile one program per variant instead of dispatching in every thread.
+     */
+    template<unsigned Features, typename RT>
+    HUSSAR_CPU_GPU void sampleVariant(const Scene &scene, const RT &rt, long index, int worker = 0) {
+        samplePath<Features>(scene, rt, index, worker);
+    }
 
-        Float sampleWeight = currentSampleWeight;
+    /**
+     * @brief Returns the variant of the sampling code for the enabled options, which are either the enabled
+     * options themselves (for common configurations) or `DynamicFeatures`.
+     */
+    HUSSAR_CPU_GPU unsigned variant() const {
+        switch (const unsigned enabled = features()) {
+        case DefaultFeatures:
+        case UnguidedFeatures:
+        case DefaultFeatures | FeatureDebugImage:
+        case UnguidedFeatures | FeatureDebugImage:
+            return enabled;
+        default:
+            return DynamicFeatures;
+        }
+    }
 
-        Vector2f primary = Vector2f::Zero();
-        Float primaryPdf = 1.f;
+#ifndef __CUDACC__
+    /// Traces the paths `[begin, end)` one after another, selecting the specialized sampling code only once.
+    template<typename RT>
+    void sampleRange(const Scene &scene, const RT &rt, long begin, long end, int worker = 0) {
+        dispatch([&](auto config) {
+            for (long index = begin; index < end; ++index)
+                samplePath<decltype(config)::value>(scene, rt, index, worker);
+        });
+    }
 
-        Complex guidingWeight = 0;
-        
-        Intersection isect;
-        Ray &ray = isect.ray;
+    /**
+     * @brief Traces the paths `[begin, end)` in waves, advancing all paths of a wave by one bounce at
+     * a time so that shadow rays and extension rays can be traced in batches (see `wavefront`).
+     *
+     * Each path consumes the same random numbers as in `sample`, hence the resulting frame only differs
+     * in the order in which contributions are accumulated. The shadow rays towards all receivers are
+     * traced in the same batch, so that rays starting at the same vertex end up in the same packet.
+     */
+    template<typename RT>
+    void sampleWavefront(const Scene &scene, const RT &rt, long begin, long end, int worker = 0) {
+        dispatch([&](auto config) {
+            sampleWaves<decltype(config)::value>(scene, rt, begin, end, worker);
+        });
+    }
+#endif
 
-        /// @todo there are multiple issues here:
-        /// * the "real" bandwidth depends on the ADC-on-time, not the rampTime
-        /// * frequency is time-dependent, but we do not model any time-dependency!
-        ///   -> could use something like spectral rendering to take care of time.
-        ///     -> that would definitely help with aliasing problems in Doppler as well!
-        ray.frequency = scene.rfConfig.startFreq + sampler.get1D() * scene.rfConfig.bandwidth();
+protected:
+    /**
+     * @brief Calls `function` with a `std::integral_constant` holding the variant of the sampling code for the
+     * enabled options (see `variant`).
+     *
+     * This removes the branches on disabled options from the inner loops of the sampling code.
+     */
+    template<typename Function>
+    HUSSAR_CPU_GPU void dispatch(Function &&function) const {
+        switch (variant()) {
+        case DefaultFeatures:
+            function(std::integral_constant<unsigned, DefaultFeatures>());
+            break;
+        case UnguidedFeatures:
+            function(std::integral_constant<unsigned, UnguidedFeatures>());
+            break;
+        case DefaultFeatures | FeatureDebugImage:
+            function(std::integral_constant<unsigned, DefaultFeatures | FeatureDebugImage>());
+            break;
+        case UnguidedFeatures | FeatureDebugImage:
+            function(std::integral_constant<unsigned, UnguidedFeatures | FeatureDebugImage>());
+            break;
+        default:
+            function(std::integral_constant<unsigned, DynamicFeatures>());
+        }
+    }
 
-        SurfaceEmitter surface;
+    /// Returns whether an option is enabled in the variant `Features` of the sampling code (see `dispatch`).
+    template<unsigned Features>
+    HUSSAR_CPU_GPU bool has(Feature feature) const {
+        if constexpr (Features == DynamicFeatures)
+            return flag(feature);
+        else
+            return Features & feature;
+    }
+
+    /// The variant `Features` of `sample` (see `dispatch`).
+    template<unsigned Features, typename RT>
+    HUSSAR_CPU_GPU void samplePath(const Scene &scene, const RT &rt, long index, int worker) {
+        PathState path;
+        startPath(scene, path, index);
 
-        Float r = 0;
-        Float cosTheta = 1;
+        Intersection *shadowRays[Scene::MaxReceivers];
+        bool visible[Scene::MaxReceivers];
 
         while (true) {
-            Vector3f tmpd = ray.d;
+            // MARK: - next event estimation
+            const int receiverCount = beginBounce<Features>(scene, path);
+            for (int receiver = 0; receiver < receiverCount; ++receiver) {
+                shadowRays[receiver] = &path.nee[receiver];
+                visible[receiver] = true;
+            }
 
-            if (ray.depth == 0) {
-                primary = sampler.get2D();
+            if (!has<Features>(FeaturePODiffraction))
+                rt.visible(shadowRays, visible, receiverCount);
 
-                if (doGuiding) {
-                    primaryPdf = guiding.sample(primary);
-                }
-                
-                scene.tx.sample(primary, ray);
-                ray.weightBy(1 / primaryPdf);
-            } else {
-                if (!useGeometricalOptics) {
-                    Vector2f rnd = sampler.get2D();
-                    surface.sample(rnd, ray);
-                } else {
-                    // geometrical optics
+            for (int receiver = 0; receiver < receiverCount; ++receiver) {
+                if (visible[receiver])
+                    connectReceiver<Features>(scene, path, receiver, worker);
+            }
 
-                    //ray.d = isect.R();
-                    //emitter->evaluate(ray); // cos explicitly included
+            if (!prepareExtension(path))
+                break;
 
-                    this->reflectRay(ray, isect); // cos not included, but included through hemisphere pdfs
-                }
+            rt.intersect(path.isect);
+            if (!finishExtension<Features>(scene, path))
+                break;
+        }
+
+        finishPath<Features>(path, worker);
+    }
+
+#ifndef __CUDACC__
+    /// The variant `Features` of `sampleWavefront` (see `dispatch`).
+    template<unsigned Features, typename RT>
+    void sampleWaves(const Scene &scene, const RT &rt, long begin, long end, int worker) {
+        constexpr long WaveSize = 256;
+
+        struct ShadowRay {
+            PathState *path;
+            int receiver;
+        };
+
+        std::vector<PathState> paths(std::min(end - begin, WaveSize));
+        std::vector<PathState *> active;
+        std::vector<ShadowRay> shadow;
+        std::vector<Intersection *> rays;
+        std::unique_ptr<bool[]> visible(new bool[paths.size() * Scene::MaxReceivers]);
+
+        active.reserve(paths.size());
+        shadow.reserve(paths.size() * Scene::MaxReceivers);
+        rays.reserve(paths.size() * Scene::MaxReceivers);
+
+        for (long waveBegin = begin; waveBegin < end; waveBegin += WaveSize) {
+            const long waveSize = std::min(end - waveBegin, WaveSize);
+
+            active.clear();
+            for (long i = 0; i < waveSize; ++i) {
+                startPath(scene, paths[i], waveBegin + i);
+                active.push_back(&paths[i]);
             }
 
-            // MARK: - next event estimation
-            /// @todo we only support single RX Radar at the moment
-            for (size_t channel = 0; channel < 1; ++channel) {
-                if (ray.depth == 0 && onlyIndirect)
-                    break;
-                
-                Intersection nee = isect;
-                nee.t = Infinity;
-                
-                Vector3c Hrx = scene.rx.nee(nee);
-                if (!poDiffraction && !rt.visible(nee))
-                    continue;
-
-                nee.t = nee.tMax;
-                if (ray.depth == 0) { /// @todo tagged dispatch
-                    scene.tx.evaluate(nee.ray);
-                    scene.tx.connect(nee);
-                } else {
-                    surface.evaluate(nee.ray);
-                    surface.connect(nee);
-                }
-                Complex v = nee.ray.measureH(Hrx);
-
-                Float dphase = 0;
-
-                if (ray.depth > 0) {
-                    if (correctPhase) {
-                        Assert(useGeometricalOptics, "only geometrical optics supported for phase correction atm");
-                        Assert(filteringSphere, "only sphere filtering supported for phase correction atm");
-
-                        auto rxPos = nee.ray(nee.t);
-                        auto virtualTx = nee.ray.o - r * ray.d;
-                        auto dist = (virtualTx - rxPos).norm();
-                        nee.ray.setDistance(dist);
-
-                        v = ray.measureH(Hrx) * (Pi * dist) / Float(
-                            std::pow(Pi * filteringRadius * nee.ray.wavelength(), 2)
-                        ); // 1 / dist falloff
-                        v /= 4 * Pi;
-                        /// @todo cos(theta)?
-                    } else if (useGeometricalOptics) {
-                        // correct for the incorrect sampling density
-                        // we sampled our last hitpoint with  'cos / r**2', but
-                        // we really want '1 / (4*Pi*r)'
-                        
-                        v *= r / cosTheta;
-                        v /= 4 * Pi;
-
-                        if (cosTheta < 1e-3) {
-                            continue;
-                        }
+            while (!active.empty()) {
+                // MARK: - next event estimation
+                shadow.clear();
+                rays.clear();
+                for (PathState *path : active) {
+                    const int receiverCount = beginBounce<Features>(scene, *path);
+                    for (int receiver = 0; receiver < receiverCount; ++receiver) {
+                        shadow.push_back({ path, receiver });
+                        rays.push_back(&path->nee[receiver]);
                     }
+                }
 
-                    if (filteringSphere) {
-                        Assert(useGeometricalOptics, "only geometrical optics supported for sphere filtering atm");
+                if (has<Features>(FeaturePODiffraction))
+                    std::fill(visible.get(), visible.get() + rays.size(), true);
+                else
+                    rt.visible(rays.data(), visible.get(), rays.size());
 
-                        auto rxPos = nee.ray(nee.t);
-                        Float lambda = std::max<Float>(0, ray.d.dot(rxPos - ray.o));
-                        Float rxDist = (ray(lambda) - rxPos).norm();
-                        dphase = rxDist;
-                    } else {
-                        Float cos = (nee.ray.d - tmpd).normalized().dot(isect.n);
-                        dphase = r * std::sqrt(1 - cos * cos) / cos;
-                    }
+                for (size_t i = 0; i < shadow.size(); ++i) {
+                    if (visible[i])
+                        connectReceiver<Features>(scene, *shadow[i].path, shadow[i].receiver, worker);
+                }
 
-                    dphase /= nee.ray.wavelength();
-
-                    if (doFiltering) {
-                        if (filteringSphere) {
-                            if (dphase > filteringRadius) {
-                                if (correctPhase) {
-                                    // when we are correcting phase, we want a hard sphere.
-
-                                    if (filterGuiding) {
-                                        // we might want a soft sphere for guiding though
-                                        guidingWeight += v / Float(std::pow(dphase / filteringRadius, 2) + 1);
-                                    }
-
-                                    v = 0;
-                                } else {
-                                    // use a soft sphere instead
-                                    //v /= Float(std::pow(dphase / filteringRadius - 1, 2) + 1);
-                                    v *= std::max<Float>(1 - 0.20 * (dphase / filteringRadius - 1), 0);
-                                }
-                            }
-                        } else {
-                            if (dphase > filteringMax) {
-                                if (filterGuiding) {
-                                    guidingWeight += v / Float(std::pow(dphase / filteringMax, 2) + 1);
-                                }
-
-                                v = 0;
-                            }
-
-                            if (dphase > filteringMin)
-                                v *= (filteringMax - dphase) / (filteringMax - filteringMin);
-                        }
+                // MARK: - random walk
+                rays.clear();
+                size_t remaining = 0;
+                for (PathState *path : active) {
+                    if (prepareExtension(*path)) {
+                        active[remaining++] = path;
+                        rays.push_back(&path->isect);
+                    } else {
+                        finishPath<Features>(*path, worker);
                     }
                 }
-                
-                //if (v == 0.f) continue;
+                active.resize(remaining);
 
-                if (ray.depth > 0) {
-                    guidingWeight += v;// * (dphase + Float(0.02f));
+                rt.intersect(rays.data(), rays.size());
+
+                remaining = 0;
+                for (PathState *path : active) {
+                    if (finishExtension<Features>(scene, *path))
+                        active[remaining++] = path;
+                    else
+                        finishPath<Features>(*path, worker);
                 }
-                
-                this->splat(scene, primary, ray.depth > 0 ? primaryPdf : 0, channel, nee.ray.time, dphase, v, sampleWeight);
+                active.resize(remaining);
             }
-            
-            // MARK: - random walk
-            if (ray.depth >= maxDepth  || r >= maxDist) /// @todo hack!
-                break;
-            
-            if (ray.getH().isZero(1e-20))
-                break;
-            
-            // intersect with scene
-            isect.reset();
-            rt.intersect(isect);
-            if (!isect.valid())
-                // this ray has no master. this ray is a free ray!
-                break;
-            
-            cosTheta = isect.cosTheta();
-            if (cosTheta < 1e-3)
-                // Grazing angles cause instabilities, since we would
-                // divide by a low cosine value. We ignore these outliers. @todo
-                break;
-            
-            r += isect.t;
-            if (!useGeometricalOptics) {
-                if (ray.depth == 0) { /// @todo tagged dispatch
-                    scene.tx.connect(isect);
-                } else {
-                    surface.connect(isect);
-                }
-                ray.weightBy(isect.t * isect.t / cosTheta); // hemisphere pdf -> surface pdf
+        }
+    }
+#endif
+
+protected:
+    /// The state of a path while it is being traced, which allows advancing paths in batches.
+    struct PathState {
+        HaltonSampler sampler;
+        long index;             ///< the index of the sample within the current guiding iteration
+        Float sampleWeight;
+        Float maxDist;
+        int transmitter;        ///< the index of the transmit antenna the path starts at
+
+        Vector2f primary;       ///< the sample in the primary sample space of the transmit antenna
+        Float primaryPdf;       ///< the effective density of the primary sample (including MIS weights)
+        Float strategyPdfs[PrimaryStrategyCount]; ///< the densities of the primary sample for each strategy
+        Complex guidingWeight;
+
+        Intersection isect;     ///< the current ray and its last intersection with the scene
+        Intersection nee[Scene::MaxReceivers]; ///< the shadow rays towards the receivers
+        Vector3c Hrx[Scene::MaxReceivers];     ///< the H fields the receivers are sensitive to along the shadow rays
+        SurfaceEmitter surface;
+
+        Vector3f lastDirection; ///< the direction of the ray before the current bounce
+        Vector3f velocity;      ///< the velocity of the surface at the current vertex of the path
+        Float pathRate;         ///< the rate at which the length of the path up to the current vertex changes
+        Float r;
+        Float cosTheta;
+    };
+
+    /**
+     * @brief Initializes a path for a given sample index.
+     *
+     * Consecutive sample indices are distributed across the transmit antennas, so that each transmit
+     * antenna receives the complete (low-discrepancy) sequence of samples.
+     */
+    HUSSAR_CPU_GPU void startPath(const Scene &scene, PathState &path, long index) {
+        const int transmitterCount = scene.tx.size();
+        path.index = sampleIndexOffset + index;
+        path.transmitter = int(path.index % transmitterCount);
+        path.sampler.setSampleIndex(path.index / transmitterCount);
+
+        path.maxDist = scene.rfConfig.adcRate / scene.rfConfig.freqSlope * radar::SPEED_OF_LIGHT; /// @todo not elegant
+        path.sampleWeight = currentSampleWeight;
+
+        path.primary = Vector2f::Zero();
+        path.primaryPdf = 1.f;
+        path.guidingWeight = 0;
+
+        path.isect = Intersection();
+        path.surface = SurfaceEmitter();
+
+        /// @todo there are multiple issues here:
+        /// * the "real" bandwidth depends on the ADC-on-time, not the rampTime
+        /// * frequency is time-dependent, but we do not model any time-dependency!
+        ///   -> could use something like spectral rendering to take care of time.
+        ///     -> that would definitely help with aliasing problems in Doppler as well!
+        path.isect.ray.frequency = scene.rfConfig.startFreq + path.sampler.get1D() * scene.rfConfig.bandwidth();
+
+        path.r = 0;
+        path.cosTheta = 1;
+
+        path.velocity = Vector3f::Zero(); // the transmitter does not move
+        path.pathRate = 0;
+    }
+
+    /**
+     * @brief Determines the ray of the current bounce and sets up the shadow rays towards all receivers.
+     *
+     * @returns the amount of receivers that should be connected (after testing the visibility of the
+     * corresponding entries of `path.nee`).
+     */
+    template<unsigned Features>
+    HUSSAR_CPU_GPU int beginBounce(const Scene &scene, PathState &path) {
+        Ray &ray = path.isect.ray;
+        path.lastDirection = ray.d;
+
+        if (ray.depth == 0) {
+            path.primary = path.sampler.get2D();
+
+            if (has<Features>(FeatureGuiding)) {
+                samplePrimary(scene, path, ray);
+            } else {
+                scene.tx[path.transmitter].sample(path.primary, ray);
+            }
+        } else {
+            if (!has<Features>(FeatureGeometricalOptics)) {
+                Vector2f rnd = path.sampler.get2D();
+                path.surface.sample(rnd, ray);
             } else {
                 // geometrical optics
-                /// @todo do we really need to multiply by 1j?
-                //ray.weightBy(Complex(0, 1) / cosTheta);
 
-                ray.addDistance(isect.t);
+                //ray.d = isect.R();
+                //emitter->evaluate(ray); // cos explicitly included
+
+                this->reflectRay(ray, path.isect); // cos not included, but included through hemisphere pdfs
             }
-            
-            if (ray.getH().isZero(1e-20))
-                break;
-            
-            // MARK: - prepare next bounce
-            surface.incoming = isect;
+        }
+
+        // MARK: - next event estimation
+        if (ray.depth == 0 && has<Features>(FeatureOnlyIndirect))
+            return 0;
 
-            ray.o = isect.p;
-            ray.depth++;
+        for (int receiver = 0; receiver < scene.rx.size(); ++receiver) {
+            Intersection &nee = path.nee[receiver];
+            nee = path.isect;
+            nee.t = Infinity;
+
+            path.Hrx[receiver] = scene.rx[receiver].nee(nee);
         }
 
-        this->incrementTotalWeight(sampleWeight);
-        this->splatDebug(primary, primaryPdf, sampleWeight);
+        return scene.rx.size();
+    }
 
-        if (doGuiding && !isFinalIteration && primaryPdf > 0) {
-            guiding.splat(std::abs(guidingWeight) * primaryPdf, {}, 1.f / primaryPdf, primary);
+    /// Samples the primary ray of a path (see `PrimarySampling`) and weights it by its density.
+    HUSSAR_CPU_GPU void samplePrimary(const Scene &scene, PathState &path, Ray &ray) {
+        path.primaryPdf = samplePrimary(
+            scene.tx[path.transmitter], guiding[path.transmitter], primarySelection[path.transmitter],
+            primarySampling.heuristic, path.primary, ray, path.strategyPdfs
+        );
+        if (path.primaryPdf > 0)
+            ray.weightBy(1 / path.primaryPdf);
+    }
+
+public:
+    /**
+     * @brief Samples a primary ray of a transmit antenna by one-sample multiple importance sampling
+     * (see `PrimarySampling`).
+     *
+     * All strategies are expressed in the primary sample space of the transmit antenna, in which the guiding
+     * distribution is learned, so that the sample and its density can be used for training.
+     *
+     * @param selection The probabilities of selecting each strategy (see `PrimaryStrategy`).
+     * @param x The sample, which is replaced by the primary sample of the antenna that yields the ray.
+     * @param pdfs Receives the densities of the strategies (see `primaryPdf`).
+     * @returns the density of the sample under the heuristic, or 0 (with the ray weighted by zero) if the
+     * antenna does not radiate into the sampled direction.
+     */
+    template<typename Tree>
+    HUSSAR_CPU_GPU static Float samplePrimary(
+        const NFAntenna &antenna, Tree &tree, const Float *selection, MISHeuristic heuristic,
+        Vector2f &x, Ray &ray, Float *pdfs
+    ) {
+        // select a strategy by remapping the first dimension of the sample
+        int last = PrimaryStrategyCount - 1;
+        while (last > 0 && selection[last] == 0)
+            --last;
+        int strategy = 0;
+        Float offset = 0;
+        while (strategy < last && (selection[strategy] == 0 || x[0] >= offset + selection[strategy]))
+            offset += selection[strategy++];
+        x[0] = std::min(std::max((x[0] - offset) / selection[strategy], Float(0)), OneMinusEpsilon);
+
+        if (strategy == GuidedStrategy) {
+            tree.sample(x);
+        } else if (strategy == UniformStrategy) {
+            const Vector3f d = antenna.rotation() * UniformSampleSphere(x);
+            if (!(antenna.pdf(d) > 0)) {
+                // the antenna does not radiate into this direction
+                ray.o = antenna.position();
+                ray.d = d;
+                ray.setWeightToZero();
+                return 0;
+            }
+            x = antenna.invert(d);
         }
+
+        antenna.sample(x, ray);
+
+        const Float balance = primaryPdf(antenna, tree, selection, x, ray.d, pdfs);
+        if (heuristic != MISHeuristic::Power)
+            return balance;
+
+        Float power = 0;
+        for (int k = 0; k < PrimaryStrategyCount; ++k)
+            power += std::pow(selection[k] * pdfs[k], 2);
+        return power / (selection[strategy] * pdfs[strategy]);
     }
 
-    HUSSAR_CPU_GPU RadarFrame fetchFrame() {
-        return this->frame / Float(totalWeight);
+    /**
+     * @brief Evaluates the density with which `samplePrimary` produces a direction (using the balance heuristic),
+     * in the primary sample space of the transmit antenna.
+     *
+     * @param x The primary sample of the direction, i.e. `antenna.invert(d)`.
+     * @param pdfs Receives the densities of the individual strategies in the primary sample space.
+     */
+    template<typename Tree>
+    HUSSAR_CPU_GPU static Float primaryPdf(
+        const NFAntenna &antenna, const Tree &tree, const Float *selection,
+        const Vector2f &x, const Vector3f &d, Float *pdfs
+    ) {
+        pdfs[PatternStrategy] = 1;
+        pdfs[GuidedStrategy] = selection[GuidedStrategy] > 0 ? tree.pdf(x) : 0;
+        pdfs[UniformStrategy] = UniformSpherePdf() / std::max(antenna.pdf(d), Epsilon);
+
+        Float balance = 0;
+        for (int k = 0; k < PrimaryStrategyCount; ++k)
+            balance += selection[k] * pdfs[k];
+        return balance;
     }
 
 protected:
-    long sampleIndexOffset;
+    /// Accumulates the second moments of the primary sampling strategies (see `adaptPrimarySelection`).
+    HUSSAR_CPU_GPU void recordPrimaryMoments(const PathState &path, int worker) {
+        const Float *selection = primarySelection[path.transmitter];
 
-#ifdef __CUDACC__
-    double totalWeight;
-#else
-    std::atomic<double> totalWeight;
-#endif
+        // the density that primary samples are drawn with (regardless of the heuristic)
+        Float density = 0;
+        for (int strategy = 0; strategy < PrimaryStrategyCount; ++strategy)
+            density += selection[strategy] * path.strategyPdfs[strategy];
+
+        const Float contribution = std::abs(path.guidingWeight) * path.primaryPdf;
+        if (!(contribution > 0 && density > 0))
+            return;
 
-    HUSSAR_CPU_GPU void incrementTotalWeight(Float sampleWeight) {
+        for (int strategy = 0; strategy < PrimaryStrategyCount; ++strategy) {
+            const double moment = double(contribution) * contribution /
+                (double(std::max(path.strategyPdfs[strategy], Epsilon)) * density);
 #ifdef __CUDACC__
-        atomicAdd(&totalWeight, static_cast<double>(sampleWeight));
+            atomicAdd(&primaryMoments.data()->values[path.transmitter][strategy], moment);
 #else
-        /// @todo this is not elegant
-        // (and could be more efficient under GCC)
-        double oldV = totalWeight;
-        while (!totalWeight.compare_exchange_weak(oldV, oldV + sampleWeight));
+            if (worker < int(primaryMoments.size()))
+                primaryMoments[worker].values[path.transmitter][strategy] += moment;
 #endif
+        }
     }
+
+    /**
+     * @brief Splats the contribution of a (visible) shadow ray towards one of the receivers.
+     *
+     * @param receiver The index of the receiver (which, together with the transmitter of the path,
+     * determines the channel of the frame).
+     */
+    template<unsigned Features>
+    HUSSAR_CPU_GPU void connectReceiver(const Scene &scene, PathState &path, int receiver, int worker) {
+        Intersection &nee = path.nee[receiver];
+        Intersection &isect = path.isect;
+        Ray &ray = isect.ray;
+        const Float r = path.r;
+        const Float cosTheta = path.cosTheta;
+
+        // receivers of an array are close to each other, hence guiding only learns from the first one
+        const bool trainsGuiding = receiver == 0;
+
+        nee.t = nee.tMax;
+        if (ray.depth == 0) { /// @todo tagged dispatch
+            scene.tx[path.transmitter].evaluate(nee.ray);
+            scene.tx[path.transmitter].connect(nee);
+        } else {
+            path.surface.evaluate(nee.ray);
+            path.surface.connect(nee);
+        }
+        Complex v = nee.ray.measureH(path.Hrx[receiver]);
+
+        Float dphase = 0;
+
+        if (ray.depth > 0) {
+            if (has<Features>(FeatureCorrectPhase)) {
+                Assert(has<Features>(FeatureGeometricalOptics), "only geometrical optics supported for phase correction atm");
+                Assert(has<Features>(FeatureFilteringSphere), "only sphere filtering supported for phase correction atm");
+
+                auto rxPos = nee.ray(nee.t);
+                auto virtualTx = nee.ray.o - r * ray.d;
+                auto dist = (virtualTx - rxPos).norm();
+                nee.ray.setDistance(dist);
+
+                v = ray.measureH(path.Hrx[receiver]) * (Pi * dist) / Float(
+                    std::pow(Pi * filteringRadius * nee.ray.wavelength(), 2)
+                ); // 1 / dist falloff
+                v /= 4 * Pi;
+                /// @todo cos(theta)?
+            } else if (has<Features>(FeatureGeometricalOptics)) {
+                // correct for the incorrect sampling density
+                // we sampled our last hitpoint with  'cos / r**2', but
+                // we really want '1 / (4*Pi*r)'
+                
+                v *= r / cosTheta;
+                v /= 4 * Pi;
+
+                if (cosTheta < 1e-3) {
+                    return;
+                }
+            }
+
+            // the deviation from the specular path (in [m]), which filtering measures in wavelengths
+            Float deviation;
+            if (has<Features>(FeatureFilteringSphere)) {
+                Assert(has<Features>(FeatureGeometricalOptics), "only geometrical optics supported for sphere filtering atm");
+
+                auto rxPos = nee.ray(nee.t);
+                Float lambda = std::max<Float>(0, ray.d.dot(rxPos - ray.o));
+                Float rxDist = (ray(lambda) - rxPos).norm();
+                deviation = rxDist;
+            } else {
+                Float cos = (nee.ray.d - path.lastDirection).normalized().dot(isect.n);
+                deviation = r * std::sqrt(1 - cos * cos) / cos;
+            }
+
+            dphase = deviation / nee.ray.wavelength();
+
+            const int frequencyCount = has<Features>(FeatureGeometricalOptics) ?
+                std::min(std::max(heroFrequencies, 1), MaxHeroFrequencies) : 1;
+            if (frequencyCount > 1) {
+                v = averageFrequencies<Features>(scene, path, nee.t, deviation, frequencyCount, v, trainsGuiding);
+            } else if (has<Features>(FeatureFiltering)) {
+                Float rejected;
+                const Float filterWeight = filter<Features>(dphase, rejected);
+                if (has<Features>(FeatureFilterGuiding) && trainsGuiding && rejected > 0)
+                    path.guidingWeight += v * rejected;
+                v *= filterWeight;
+            }
+        }
+        
+        //if (v == 0.f) continue;
+
+        if (ray.depth > 0 && trainsGuiding) {
+            path.guidingWeight += v;// * (dphase + Float(0.02f));
+        }
+        
+        // the receiver does not move, hence only the current vertex affects the last segment
+        const Float pathRate = path.pathRate - path.velocity.dot(nee.ray.d);
+
+        // each transmit antenna is only used by every `scene.tx.size()`-th path
+        const Float weight = path.sampleWeight * scene.tx.size();
+
+        this->template splat<bool(Features & FeatureDebugImage)>(scene, path.primary, ray.depth > 0 ? path.primaryPdf : 0, path.transmitter, receiver, nee.ray.time, pathRate / 2, dphase, v, weight, worker);
+    }
+
+    /**
+     * @brief Returns the weight that filtering applies to a connection (see `doFiltering`).
+     *
+     * All weights are computed before one is selected, since branches would prevent evaluating it for several
+     * frequencies at once (see `averageFrequencies`).
+     *
+     * @param dphase The deviation of the connection from the specular path (in wavelengths).
+     * @param rejected Receives the weight of the part of the contribution that has been filtered out, but should
+     *                 still be learned by guiding (see `filterGuiding`).
+     */
+    template<unsigned Features>
+    HUSSAR_CPU_GPU Float filter(Float dphase, Float &rejected) const {
+        if (has<Features>(FeatureFilteringSphere)) {
+            const bool isOutside = dphase > filteringRadius;
+            if (has<Features>(FeatureCorrectPhase)) {
+                // when we are correcting phase, we want a hard sphere.
+                // we might want a soft sphere for guiding though
+                const Float soft = 1 / (std::pow(dphase / filteringRadius, 2) + 1);
+                rejected = isOutside ? soft : 0;
+                return isOutside ? 0 : 1;
+            }
+
+            // use a soft sphere instead
+            //v /= Float(std::pow(dphase / filteringRadius - 1, 2) + 1);
+            const Float soft = std::max<Float>(1 - 0.20 * (dphase / filteringRadius - 1), 0);
+            rejected = 0;
+            return isOutside ? soft : 1;
+        }
+
+        const bool isOutside = dphase > filteringMax;
+        const Float soft = 1 / (std::pow(dphase / filteringMax, 2) + 1);
+        const Float fade = (filteringMax - dphase) / (filteringMax - filteringMin);
+        rejected = isOutside ? soft : 0;
+        return isOutside ? 0 : (dphase > filteringMin ? fade : 1);
+    }
+
+public:
+    /**
+     * @brief Returns one of the frequencies that a connection is evaluated for (see `heroFrequencies`).
+     *
+     * The frequencies are spread evenly across the bandwidth of the chirp (wrapping around at its end),
+     * starting at the frequency of the path.
+     */
+    HUSSAR_CPU_GPU static Float heroFrequency(const radar::RFConfig &rf, Float frequency, int lane, int count) {
+        // the frequency of the path is returned exactly instead of being subject to rounding
+        return lane == 0 ? frequency : spreadFrequency(rf, frequency, lane, count);
+    }
+
+protected:
+    /// Like `heroFrequency`, but without treating the first lane separately.
+    HUSSAR_CPU_GPU static Float spreadFrequency(const radar::RFConfig &rf, Float frequency, int lane, int count) {
+        Float offset = (frequency - rf.startFreq) / rf.bandwidth() + Float(lane) / count;
+        offset -= int(offset); // the offset is never negative (and unlike floor, truncation vectorizes)
+        return rf.startFreq + offset * rf.bandwidth();
+    }
+
+    /**
+     * @brief Evaluates the connection of a geometrical optics path to a receiver for several frequencies
+     * (see `heroFrequencies`) and returns their average contribution.
+     *
+     * The factors that depend on the frequency are kept in one array per factor, so that the loops over
+     * the frequencies are vectorized.
+     *
+     * @param distance The length of the last segment of the connection.
+     * @param deviation The deviation of the connection from the specular path (in [m]).
+     * @param v The contribution for the frequency of the path (before filtering).
+     */
+    template<unsigned Features>
+    HUSSAR_CPU_GPU Complex averageFrequencies(
+        const Scene &scene, PathState &path,
+        Float distance, Float deviation, int count,
+        const Complex &v, bool trainsGuiding
+    ) const {
+        const Float frequency = path.isect.ray.frequency;
+        const Float waveNumber = 2 * Pi / radar::SPEED_OF_LIGHT;
+
+        // branches inside the loops over lanes would prevent their vectorization
+        Float laneFrequencies[MaxHeroFrequencies];
+        for (int l = 0; l < count; ++l)
+            laneFrequencies[l] = spreadFrequency(scene.rfConfig, frequency, l, count);
+        laneFrequencies[0] = frequency;
+
+        // the frequency dependent factors, which scale the contribution at the path's frequency
+        Float re[MaxHeroFrequencies], im[MaxHeroFrequencies];
+        Float weight[MaxHeroFrequencies], rejected[MaxHeroFrequencies];
+        for (int l = 0; l < count; ++l) {
+            const Float laneFrequency = laneFrequencies[l];
+            if (has<Features>(FeatureCorrectPhase)) {
+                // the contribution scales with the inverse square of the wavelength
+                re[l] = laneFrequency * laneFrequency;
+                im[l] = 0;
+            } else {
+                const Complex green = SurfaceEmitter::green(waveNumber * laneFrequency, distance);
+                re[l] = green.real();
+                im[l] = green.imag();
+            }
+
+            rejected[l] = 0;
+            weight[l] = has<Features>(FeatureFiltering) ?
+                filter<Features>(deviation * laneFrequency / radar::SPEED_OF_LIGHT, rejected[l]) : 1;
+        }
+
+        Complex sum = 0, rejectedSum = 0;
+        for (int l = 0; l < count; ++l) {
+            sum += weight[l] * Complex(re[l], im[l]);
+            rejectedSum += rejected[l] * Complex(re[l], im[l]);
+        }
+
+        // the contribution divided by the frequency dependent factors at the path's frequency
+        const Complex base = has<Features>(FeatureCorrectPhase) ?
+            v / (frequency * frequency) :
+            v / SurfaceEmitter::green(waveNumber * frequency, distance);
+
+        if (has<Features>(FeatureFiltering) && has<Features>(FeatureFilterGuiding) && trainsGuiding)
+            path.guidingWeight += base * rejectedSum / Float(count);
+        return base * sum / Float(count);
+    }
+
+    /**
+     * @brief Decides whether the path continues and prepares `path.isect` for intersection with the scene.
+     *
+     * @returns false if the path should be terminated.
+     */
+    HUSSAR_CPU_GPU bool prepareExtension(PathState &path) const {
+        const Ray &ray = path.isect.ray;
+
+        // MARK: - random walk
+        if (ray.depth >= maxDepth  || path.r >= path.maxDist) /// @todo hack!
+            return false;
+        
+        if (ray.getH().isZero(1e-20))
+            return false;
+        
+        path.isect.reset();
+        return true;
+    }
+
+    /**
+     * @brief Accounts for the intersection found for `path.isect` and moves the path to the hit point.
+     *
+     * @returns false if the path should be terminated.
+     */
+    template<unsigned Features>
+    HUSSAR_CPU_GPU bool finishExtension(const Scene &scene, PathState &path) const {
+        Intersection &isect = path.isect;
+        Ray &ray = isect.ray;
+
+        if (!isect.valid())
+            // this ray has no master. this ray is a free ray!
+            return false;
+        
+        path.cosTheta = isect.cosTheta();
+        if (path.cosTheta < 1e-3)
+            // Grazing angles cause instabilities, since we would
+            // divide by a low cosine value. We ignore these outliers. @todo
+            return false;
+        
+        path.r += isect.t;
+        if (!has<Features>(FeatureGeometricalOptics)) {
+            if (ray.depth == 0) { /// @todo tagged dispatch
+                scene.tx[path.transmitter].connect(isect);
+            } else {
+                path.surface.connect(isect);
+            }
+            ray.weightBy(isect.t * isect.t / path.cosTheta); // hemisphere pdf -> surface pdf
+        } else {
+            // geometrical optics
+            /// @todo do we really need to multiply by 1j?
+            //ray.weightBy(Complex(0, 1) / cosTheta);
+
+            ray.addDistance(isect.t);
+        }
+        
+        if (ray.getH().isZero(1e-20))
+            return false;
+        
+        // the length of a segment changes with the velocities of its endpoints along its direction
+        path.pathRate += (isect.velocity - path.velocity).dot(ray.d);
+        path.velocity = isect.velocity;
+
+        // MARK: - prepare next bounce
+        path.surface.incoming = isect;
+
+        ray.o = isect.p;
+        ray.depth++;
+        return true;
+    }
+
+    /// Accounts for the weight of a finished path and trains the guiding distribution with it.
+    template<unsigned Features>
+    HUSSAR_CPU_GPU void finishPath(PathState &path, int worker) {
+        this->incrementTotalWeight(path.sampleWeight, worker);
+        if (path.primaryPdf > 0)
+            this->template splatDebug<bool(Features & FeatureDebugImage)>(path.primary, path.primaryPdf, path.sampleWeight, worker);
+
+        if (has<Features>(FeatureGuiding) && !isFinalIteration && path.primaryPdf > 0) {
+            guiding[path.transmitter].record(worker, path.index, std::abs(path.guidingWeight) * path.primaryPdf, {}, 1.f / path.primaryPdf, path.primary);
+            recordPrimaryMoments(path, worker);
+        }
+    }
+
+protected:
+    long sampleIndexOffset = 0;
 };
 
 }
@@ -0,0 +1,64 @@
+#ifndef HUSSAR_IO_GUIDINGCACHE_H
+#define HUSSAR_IO_GUIDINGCACHE_H
+
+#include <hussar/hussar.h>
+#include <hussar/core/mesh.h>
+#include <hussar/core/scene.h>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace hussar {
+
+/**
+ * @brief Stores trained guiding distributions on disk, so that reruns of known scenes and trajectories
+ * can skip training entirely (see `PathTracer::guidingCache`).
+ *
+ * Entries are keyed by a hash of the mesh (including its motions), the poses and patterns of the antennas, the
+ * RF configuration and the settings of the integrator that affect training, and each entry is stored in a file
+ * of its own in the cache directory. The trees of libguiding cannot be
+ * serialized, hence each distribution is stored as its density tabulated on a regular grid
+ * (see `GuidingWrapper::tabulate`), from which the tree is learned again when the entry is loaded.
+ */
+class GuidingCache {
+public:
+    struct Entry {
+        /// The amount of cells along each axis of the tables.
+        int resolution = 0;
+        /// The probability of sampling uniformly instead of following the distributions, which the tables exclude.
+        Float uniformProb = 0;
+        /// The tabulated densities, one table per transmit antenna.
+        std::vector<std::vector<Float>> densities;
+    };
+
+    /// Creates a cache for a mesh, storing its entries in an existing directory.
+    GuidingCache(const std::string &directory, const TriangleMesh &mesh);
+
+    /**
+     * @brief Computes the key of the entry for a configuration of the antennas (in the mesh of this cache).
+     *
+     * @param settings A hash of the settings of the integrator that affect the trained distributions
+     * (see `PathTracer::guidingSettingsHash`).
+     */
+    uint64_t key(const Scene &scene, uint64_t settings) const;
+
+    /// Loads an entry, returning false if it does not exist or could not be read.
+    bool load(uint64_t key, Entry &entry) const;
+
+    /// Stores an entry, replacing any previous entry with the same key. Failures are logged.
+    void store(uint64_t key, const Entry &entry) const;
+
+    /// Hashes a sequence of bytes (using 64-bit FNV-1a), optionally continuing a previous hash.
+    static uint64_t hash(const void *data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
+
+private:
+    std::string path(uint64_t key) const;
+
+    std::string m_directory;
+    uint64_t m_meshHash;
+};
+
+}
+
+#endif
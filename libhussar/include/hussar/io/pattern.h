@@ -0,0 +1,32 @@
+#ifndef HUSSAR_IO_PATTERN_H
+#define HUSSAR_IO_PATTERN_H
+
+#include <hussar/hussar.h>
+#include <hussar/core/emitter.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace hussar {
+
+/// Reports malformed radiation pattern files.
+struct PatternError : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Loads a measured radiation pattern (e.g. a goniometer capture) from a text file.
+ *
+ * Every line holds the azimuth and elevation (in degrees, see `TabulatedAngularDistribution`) and the
+ * measured power gain (in dB) of one direction, separated by whitespace or commas. The directions need to
+ * form a regular grid that covers the entire sphere, in any order. Empty lines and lines starting with '#'
+ * are ignored. Gains are converted to field amplitudes (i.e. `10^(gain / 20)`), hence -20 dB yields 0.1.
+ *
+ * @param resolution The resolution of the table the measurements are resampled to.
+ * @throws PatternError if the file cannot be read or does not describe a regular grid.
+ */
+TabulatedAngularDistribution loadAntennaPattern(const std::string &path, int resolution = 128);
+
+}
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <embree3/rtcore.h>
 
+#include <algorithm>
+
 namespace hussar {
 namespace cpu {
 
@@ -17,6 +19,39 @@ RTCRay rayFromIntersection(const Intersection &isect) {
     };
 }
 
+/// The number of rays traced at once by the batched queries, matching the widest packets of Embree.
+constexpr size_t PacketSize = 16;
+
+/// Writes a ray into one lane of a ray packet.
+template<typename Packet>
+void setPacketRay(Packet &packet, size_t lane, const Intersection &isect) {
+    RTCRay ray = rayFromIntersection(isect);
+    packet.org_x[lane] = ray.org_x;
+    packet.org_y[lane] = ray.org_y;
+    packet.org_z[lane] = ray.org_z;
+    packet.tnear[lane] = ray.tnear;
+    packet.dir_x[lane] = ray.dir_x;
+    packet.dir_y[lane] = ray.dir_y;
+    packet.dir_z[lane] = ray.dir_z;
+    packet.time[lane]  = ray.time;
+    packet.tfar[lane]  = ray.tfar;
+    packet.mask[lane]  = ray.mask;
+    packet.id[lane]    = ray.id;
+    packet.flags[lane] = ray.flags;
+}
+
+/// Records a hit found by Embree in an intersection object.
+void applyHit(Intersection &isect, float tfar, float Ng_x, float Ng_y, float Ng_z) {
+    isect.t = tfar;
+    isect.p = isect.ray(isect.t);
+    isect.n = Vector3f(Ng_x, Ng_y, Ng_z).normalized();
+
+    if (isect.n.dot(isect.ray.d) > 0) {
+        // faceforward
+        isect.n = -isect.n;
+    }
+}
+
 RTCDevice getEmbreeDevice() {
     static bool EMBREE_INITIALIZED = false;
     static RTCDevice device;
@@ -29,7 +64,8 @@ RTCDevice getEmbreeDevice() {
     return device;
 }
 
-Backend::RT::RT(const TriangleMesh &mesh) {
+Backend::RT::RT(const TriangleMesh &mesh)
+: m_motions(mesh.motionBuffer), m_motionIndices(mesh.motionIndices()) {
     m_scene = rtcNewScene(getEmbreeDevice());
     RTCGeometry geometry = rtcNewGeometry(getEmbreeDevice(), RTC_GEOMETRY_TYPE_TRIANGLE);
 
@@ -50,6 +86,15 @@ Backend::RT::~RT() {
     rtcReleaseScene(m_scene);
 }
 
+void Backend::RT::applyMotion(Intersection &isect, unsigned int primID) const {
+    if (m_motionIndices.empty())
+        return;
+
+    const int motion = m_motionIndices[primID];
+    if (motion != TriangleMesh::Static)
+        isect.velocity = m_motions[motion].velocityAt(isect.p);
+}
+
 bool Backend::RT::visible(Intersection &isect) const {
     RTCIntersectContext context;
     rtcInitIntersectContext(&context);
@@ -71,17 +116,86 @@ void Backend::RT::intersect(Intersection &isect) const {
     rtcIntersect1(m_scene, &context, &rayhit);
 
     if (rayhit.hit.geomID != RTC_INVALID_GEOMETRY_ID) {
-        isect.t = rayhit.ray.tfar;
-        isect.p = isect.ray(isect.t);
-        isect.n = Vector3f(
-            rayhit.hit.Ng_x,
-            rayhit.hit.Ng_y,
-            rayhit.hit.Ng_z
-        ).normalized();
-
-        if (isect.n.dot(isect.ray.d) > 0) {
-            // faceforward
-            isect.n = -isect.n;
+        applyHit(isect, rayhit.ray.tfar, rayhit.hit.Ng_x, rayhit.hit.Ng_y, rayhit.hit.Ng_z);
+        applyMotion(isect, rayhit.hit.primID);
+    }
+}
+
+/**
+ * @brief Tests the visibility of up to `Width` shadow rays using a single ray packet.
+ *
+ * @param occluded The Embree query matching the packet type, e.g. `rtcOccluded4`.
+ */
+template<size_t Width, typename Packet>
+void occludedPacket(
+    void (*occluded)(const int *, RTCScene, RTCIntersectContext *, Packet *),
+    RTCScene scene, RTCIntersectContext &context,
+    Intersection *const *isects, bool *results, size_t laneCount
+) {
+    alignas(4 * Width) int valid[Width];
+    Packet packet;
+    for (size_t lane = 0; lane < Width; ++lane) {
+        valid[lane] = lane < laneCount ? -1 : 0;
+        if (lane < laneCount)
+            setPacketRay(packet, lane, *isects[lane]);
+    }
+
+    occluded(valid, scene, &context, &packet);
+
+    for (size_t lane = 0; lane < laneCount; ++lane)
+        results[lane] = packet.tfar[lane] >= 0.f;
+}
+
+void Backend::RT::visible(Intersection *const *isects, bool *results, size_t count) const {
+    RTCIntersectContext context;
+    rtcInitIntersectContext(&context);
+
+    for (size_t offset = 0; offset < count; offset += PacketSize) {
+        const size_t laneCount = std::min(PacketSize, count - offset);
+
+        // use the narrowest packet that fits, e.g. for the shadow rays towards a few receivers
+        if (laneCount == 1) {
+            results[offset] = visible(*isects[offset]);
+        } else if (laneCount <= 4) {
+            occludedPacket<4>(rtcOccluded4, m_scene, context, isects + offset, results + offset, laneCount);
+        } else if (laneCount <= 8) {
+            occludedPacket<8>(rtcOccluded8, m_scene, context, isects + offset, results + offset, laneCount);
+        } else {
+            occludedPacket<16>(rtcOccluded16, m_scene, context, isects + offset, results + offset, laneCount);
+        }
+    }
+}
+
+void Backend::RT::intersect(Intersection *const *isects, size_t count) const {
+    RTCIntersectContext context;
+    rtcInitIntersectContext(&context);
+
+    for (size_t offset = 0; offset < count; offset += PacketSize) {
+        const size_t laneCount = std::min(PacketSize, count - offset);
+
+        // Embree requires the valid mask to be aligned to the size of the packet
+        alignas(4 * PacketSize) int valid[PacketSize];
+        RTCRayHit16 packet;
+        for (size_t lane = 0; lane < PacketSize; ++lane) {
+            valid[lane] = lane < laneCount ? -1 : 0;
+            if (lane < laneCount)
+                setPacketRay(packet.ray, lane, *isects[offset + lane]);
+            packet.hit.geomID[lane] = RTC_INVALID_GEOMETRY_ID;
+        }
+
+        rtcIntersect16(valid, m_scene, &context, &packet);
+
+        for (size_t lane = 0; lane < laneCount; ++lane) {
+            if (packet.hit.geomID[lane] != RTC_INVALID_GEOMETRY_ID) {
+                applyHit(
+                    *isects[offset + lane],
+                    packet.ray.tfar[lane],
+                    packet.hit.Ng_x[lane],
+                    packet.hit.Ng_y[lane],
+                    packet.hit.Ng_z[lane]
+                );
+                applyMotion(*isects[offset + lane], packet.hit.primID[lane]);
+            }
         }
     }
 }
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <iomanip>
+#include <vector>
 
 #include <hussar/arch/gpu.h>
 #include "gpu/device/kernel.h"
@@ -21,12 +22,14 @@ struct BackendState {
     CUdeviceptr d_gas_output_buffer = 0;   // Triangle AS memory
     CUdeviceptr d_vertices = 0;
     CUdeviceptr d_indices = 0;
+    CUdeviceptr d_motions = 0;
+    CUdeviceptr d_motion_indices = 0; // stays 0 if the scene is static
 
     OptixModule ptx_module = 0;
     OptixPipelineCompileOptions pipeline_compile_options = {};
     OptixPipeline pipeline = 0;
 
-    OptixProgramGroup raygen_prog_group = 0;
+    OptixProgramGroup raygen_prog_groups[RAYGEN_PROGRAM_COUNT] = {}; // one per variant of the sampling code
     OptixProgramGroup radiance_miss_group = 0;
     OptixProgramGroup occlusion_miss_group = 0;
     OptixProgramGroup radiance_hit_group = 0;
@@ -36,6 +39,7 @@ struct BackendState {
     GPUParams params;
     GPUParams *d_params;
 
+    CUdeviceptr d_raygen_records = 0; // one per raygen program, selected for each launch
     OptixShaderBindingTable sbt = {};
 };
 
@@ -106,6 +110,23 @@ void buildMeshAccel(BackendState &state, const TriangleMesh &mesh)
         mesh.indexBuffer.data(), indices_size_in_bytes,
         cudaMemcpyHostToDevice));
 
+    const std::vector<int> motion_indices = mesh.motionIndices();
+    if (!motion_indices.empty()) {
+        const size_t motions_size_in_bytes = mesh.motionBuffer.size() * sizeof(mesh.motionBuffer[0]);
+        CUDA_CHECK(cudaMalloc(reinterpret_cast<void **>(&state.d_motions), motions_size_in_bytes));
+        CUDA_CHECK(cudaMemcpy(
+            reinterpret_cast<void *>(state.d_motions),
+            mesh.motionBuffer.data(), motions_size_in_bytes,
+            cudaMemcpyHostToDevice));
+
+        const size_t motion_indices_size_in_bytes = motion_indices.size() * sizeof(motion_indices[0]);
+        CUDA_CHECK(cudaMalloc(reinterpret_cast<void **>(&state.d_motion_indices), motion_indices_size_in_bytes));
+        CUDA_CHECK(cudaMemcpy(
+            reinterpret_cast<void *>(state.d_motion_indices),
+            motion_indices.data(), motion_indices_size_in_bytes,
+            cudaMemcpyHostToDevice));
+    }
+
     CUdeviceptr d_mat_indices = 0;
     const size_t mat_indices_size_in_bytes = mat_indices.size() * sizeof(uint32_t);
     CUDA_CHECK(cudaMalloc(reinterpret_cast<void **>(&d_mat_indices), mat_indices_size_in_bytes));
@@ -248,11 +269,11 @@ void createProgramGroups(BackendState &state)
     char log[2048];
     size_t sizeof_log;
 
-    {
+    for (int i = 0; i < RAYGEN_PROGRAM_COUNT; ++i) {
         OptixProgramGroupDesc raygen_prog_group_desc = {};
         raygen_prog_group_desc.kind = OPTIX_PROGRAM_GROUP_KIND_RAYGEN;
         raygen_prog_group_desc.raygen.module = state.ptx_module;
-        raygen_prog_group_desc.raygen.entryFunctionName = "__raygen__rg";
+        raygen_prog_group_desc.raygen.entryFunctionName = RaygenPrograms[i].entryFunctionName;
         sizeof_log = sizeof(log);
         OPTIX_CHECK_LOG(optixProgramGroupCreate(
             state.context, &raygen_prog_group_desc,
@@ -260,7 +281,7 @@ void createProgramGroups(BackendState &state)
             &program_group_options,
             log,
             &sizeof_log,
-            &state.raygen_prog_group));
+            &state.raygen_prog_groups[i]));
     }
 
     {
@@ -323,12 +344,11 @@ void createProgramGroups(BackendState &state)
 
 void createPipeline(BackendState &state)
 {
-    OptixProgramGroup program_groups[] = {
-        state.raygen_prog_group,
-        state.radiance_miss_group,
-        state.occlusion_miss_group,
-        state.radiance_hit_group,
-        state.occlusion_hit_group};
+    std::vector<OptixProgramGroup> program_groups(state.raygen_prog_groups, state.raygen_prog_groups + RAYGEN_PROGRAM_COUNT);
+    program_groups.push_back(state.radiance_miss_group);
+    program_groups.push_back(state.occlusion_miss_group);
+    program_groups.push_back(state.radiance_hit_group);
+    program_groups.push_back(state.occlusion_hit_group);
 
     OptixPipelineLinkOptions pipeline_link_options = {};
     pipeline_link_options.maxTraceDepth = 2;
@@ -340,8 +360,8 @@ void createPipeline(BackendState &state)
         state.context,
         &state.pipeline_compile_options,
         &pipeline_link_options,
-        program_groups,
-        sizeof(program_groups) / sizeof(program_groups[0]),
+        program_groups.data(),
+        static_cast<unsigned int>(program_groups.size()),
         log,
         &sizeof_log,
         &state.pipeline));
@@ -349,11 +369,8 @@ void createPipeline(BackendState &state)
     // We need to specify the max traversal depth.  Calculate the stack sizes, so we can specify all
     // parameters to optixPipelineSetStackSize.
     OptixStackSizes stack_sizes = {};
-    OPTIX_CHECK(optixUtilAccumulateStackSizes(state.raygen_prog_group, &stack_sizes));
-    OPTIX_CHECK(optixUtilAccumulateStackSizes(state.radiance_miss_group, &stack_sizes));
-    OPTIX_CHECK(optixUtilAccumulateStackSizes(state.occlusion_miss_group, &stack_sizes));
-    OPTIX_CHECK(optixUtilAccumulateStackSizes(state.radiance_hit_group, &stack_sizes));
-    OPTIX_CHECK(optixUtilAccumulateStackSizes(state.occlusion_hit_group, &stack_sizes));
+    for (OptixProgramGroup group : program_groups)
+        OPTIX_CHECK(optixUtilAccumulateStackSizes(group, &stack_sizes));
 
     uint32_t max_trace_depth = 2;
     uint32_t max_cc_depth = 0;
@@ -384,17 +401,17 @@ void createPipeline(BackendState &state)
 
 void createSBT(BackendState &state)
 {
-    CUdeviceptr d_raygen_record;
     const size_t raygen_record_size = sizeof(RayGenRecord);
-    CUDA_CHECK(cudaMalloc(reinterpret_cast<void **>(&d_raygen_record), raygen_record_size));
+    CUDA_CHECK(cudaMalloc(reinterpret_cast<void **>(&state.d_raygen_records), raygen_record_size * RAYGEN_PROGRAM_COUNT));
 
-    RayGenRecord rg_sbt = {};
-    OPTIX_CHECK(optixSbtRecordPackHeader(state.raygen_prog_group, &rg_sbt));
+    RayGenRecord rg_sbt[RAYGEN_PROGRAM_COUNT] = {};
+    for (int i = 0; i < RAYGEN_PROGRAM_COUNT; ++i)
+        OPTIX_CHECK(optixSbtRecordPackHeader(state.raygen_prog_groups[i], &rg_sbt[i]));
 
     CUDA_CHECK(cudaMemcpy(
-        reinterpret_cast<void *>(d_raygen_record),
-        &rg_sbt,
-        raygen_record_size,
+        reinterpret_cast<void *>(state.d_raygen_records),
+        rg_sbt,
+        raygen_record_size * RAYGEN_PROGRAM_COUNT,
         cudaMemcpyHostToDevice));
 
     CUdeviceptr d_miss_records;
@@ -427,6 +444,8 @@ void createSBT(BackendState &state)
             OPTIX_CHECK(optixSbtRecordPackHeader(state.radiance_hit_group, &hitgroup_records[sbt_idx]));
             hitgroup_records[sbt_idx].data.vertices = reinterpret_cast<Vector3f *>(state.d_vertices);
             hitgroup_records[sbt_idx].data.indices = reinterpret_cast<TriangleMesh::IndexTriplet *>(state.d_indices);
+            hitgroup_records[sbt_idx].data.motions = reinterpret_cast<TriangleMesh::Motion *>(state.d_motions);
+            hitgroup_records[sbt_idx].data.motionIndices = reinterpret_cast<int *>(state.d_motion_indices);
         }
 
         {
@@ -443,7 +462,7 @@ void createSBT(BackendState &state)
         hitgroup_record_size * RAY_TYPE_COUNT * MAT_COUNT,
         cudaMemcpyHostToDevice));
 
-    state.sbt.raygenRecord = d_raygen_record;
+    state.sbt.raygenRecord = state.d_raygen_records; // replaced for each launch (see Backend::run)
     state.sbt.missRecordBase = d_miss_records;
     state.sbt.missRecordStrideInBytes = static_cast<uint32_t>(miss_record_size);
     state.sbt.missRecordCount = RAY_TYPE_COUNT;
@@ -460,7 +479,8 @@ void createParams(BackendState &state)
 void cleanupState(BackendState &state)
 {
     OPTIX_CHECK(optixPipelineDestroy(state.pipeline));
-    OPTIX_CHECK(optixProgramGroupDestroy(state.raygen_prog_group));
+    for (OptixProgramGroup group : state.raygen_prog_groups)
+        OPTIX_CHECK(optixProgramGroupDestroy(group));
     OPTIX_CHECK(optixProgramGroupDestroy(state.radiance_miss_group));
     OPTIX_CHECK(optixProgramGroupDestroy(state.radiance_hit_group));
     OPTIX_CHECK(optixProgramGroupDestroy(state.occlusion_hit_group));
@@ -468,10 +488,12 @@ void cleanupState(BackendState &state)
     OPTIX_CHECK(optixModuleDestroy(state.ptx_module));
     OPTIX_CHECK(optixDeviceContextDestroy(state.context));
 
-    CUDA_CHECK(cudaFree(reinterpret_cast<void *>(state.sbt.raygenRecord)));
+    CUDA_CHECK(cudaFree(reinterpret_cast<void *>(state.d_raygen_records)));
     CUDA_CHECK(cudaFree(reinterpret_cast<void *>(state.sbt.missRecordBase)));
     CUDA_CHECK(cudaFree(reinterpret_cast<void *>(state.sbt.hitgroupRecordBase)));
     CUDA_CHECK(cudaFree(reinterpret_cast<void *>(state.d_vertices)));
+    CUDA_CHECK(cudaFree(reinterpret_cast<void *>(state.d_motions)));
+    CUDA_CHECK(cudaFree(reinterpret_cast<void *>(state.d_motion_indices)));
     CUDA_CHECK(cudaFree(reinterpret_cast<void *>(state.d_gas_output_buffer)));
     CUDA_CHECK(cudaFree(reinterpret_cast<void *>(state.d_params)));
 }
@@ -512,6 +534,13 @@ void Backend::run(PathTracer &integrator, const Scene &scene, long budget) {
     state.params.d_scene = &scene;
     state.params.d_integrator = &integrator;
 
+    // select the program that is specialized for the options of the integrator
+    const unsigned variant = integrator.variant();
+    int program = 0;
+    while (program < RAYGEN_PROGRAM_COUNT - 1 && RaygenPrograms[program].features != variant)
+        ++program;
+    state.sbt.raygenRecord = state.d_raygen_records + program * sizeof(RayGenRecord);
+
     CUDA_CHECK(cudaMemcpyAsync(
         reinterpret_cast<void *>(state.d_params),
         &state.params, sizeof(GPUParams),
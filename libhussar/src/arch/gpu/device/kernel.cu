@@ -42,6 +42,11 @@ struct RT {
         return visible;
     }
 
+    void visible(Intersection *const *isects, bool *results, int count) const {
+        for (int i = 0; i < count; ++i)
+            results[i] = visible(*isects[i]);
+    }
+
     void intersect(Intersection &isect) const {
         unsigned int u0, u1;
         packPointer(&isect, u0, u1);
@@ -63,14 +68,36 @@ struct RT {
     }
 };
 
-extern "C" __global__ void __raygen__rg() {
+template<unsigned Features>
+RT_FUNCTION void raygen() {
     const uint3 optixIndex = optixGetLaunchIndex();
     const long sampleIndex = optixIndex.y * params.width + optixIndex.x + params.offset;
 
     const Scene &scene = *params.d_scene;
     PathTracer &integrator = *params.d_integrator;
 
-    integrator.sample(scene, RT {}, sampleIndex);
+    integrator.sampleVariant<Features>(scene, RT {}, sampleIndex);
+}
+
+// one entry point per variant of the sampling code, which the host selects for each launch (see `RaygenPrograms`)
+extern "C" __global__ void __raygen__default() {
+    raygen<PathTracer::DefaultFeatures>();
+}
+
+extern "C" __global__ void __raygen__unguided() {
+    raygen<PathTracer::UnguidedFeatures>();
+}
+
+extern "C" __global__ void __raygen__default_debug() {
+    raygen<PathTracer::DefaultFeatures | PathTracer::FeatureDebugImage>();
+}
+
+extern "C" __global__ void __raygen__unguided_debug() {
+    raygen<PathTracer::UnguidedFeatures | PathTracer::FeatureDebugImage>();
+}
+
+extern "C" __global__ void __raygen__dynamic() {
+    raygen<PathTracer::DynamicFeatures>();
 }
 
 extern "C" __global__ void __closesthit__radiance() {
@@ -95,6 +122,12 @@ extern "C" __global__ void __closesthit__radiance() {
   isect.t = optixGetRayTmax();
   isect.p = float3_to_vec3(optixGetWorldRayOrigin() + optixGetRayTmax() * optixGetWorldRayDirection());
   isect.n = float3_to_vec3(faceforward(normal, -optixGetWorldRayDirection(), normal));
+
+  if (rt_data->motionIndices) {
+    const int motion = rt_data->motionIndices[optixGetPrimitiveIndex()];
+    if (motion != TriangleMesh::Static)
+      isect.velocity = rt_data->motions[motion].velocityAt(isect.p);
+  }
 }
 
 extern "C" __global__ void __miss__radiance() {
@@ -27,6 +27,23 @@ struct GPUParams {
     OptixTraversableHandle handle;
 };
 
+/// A raygen entry point of the kernel, which runs one variant of the sampling code (see `PathTracer::variant`).
+struct RaygenProgram {
+    unsigned features;
+    const char *entryFunctionName;
+};
+
+/// The last program is used for all variants that have no program of their own.
+constexpr RaygenProgram RaygenPrograms[] = {
+    { PathTracer::DefaultFeatures,                                   "__raygen__default" },
+    { PathTracer::UnguidedFeatures,                                  "__raygen__unguided" },
+    { PathTracer::DefaultFeatures | PathTracer::FeatureDebugImage,   "__raygen__default_debug" },
+    { PathTracer::UnguidedFeatures | PathTracer::FeatureDebugImage,  "__raygen__unguided_debug" },
+    { PathTracer::DynamicFeatures,                                   "__raygen__dynamic" },
+};
+
+constexpr int RAYGEN_PROGRAM_COUNT = sizeof(RaygenPrograms) / sizeof(RaygenPrograms[0]);
+
 struct RayGenData {
 };
 
@@ -36,6 +53,8 @@ struct MissData {
 struct HitGroupData {
     Vector3f *vertices;
     TriangleMesh::IndexTriplet *indices;
+    TriangleMesh::Motion *motions;
+    int *motionIndices; ///< nullptr if the scene is static
 };
 
 }
@@ -0,0 +1,153 @@
+#include <hussar/io/guidingcache.h>
+#include <hussar/core/logging.h>
+
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+namespace hussar {
+
+namespace {
+
+const char Magic[8] = { 'H', 'G', 'U', 'I', 'D', 'E', '0', '1' };
+
+/// Bounds the resolution of entries, which also keeps the size of their tables from overflowing.
+constexpr uint32_t MaxResolution = 1 << 14;
+
+struct FileHeader {
+    char magic[8];
+    uint64_t key;
+    uint32_t resolution;
+    uint32_t transmitterCount;
+    float uniformProb;
+    uint32_t reserved;
+};
+
+uint64_t hashAntennas(const NFAntenna *begin, const NFAntenna *end, uint64_t seed) {
+    for (const NFAntenna *antenna = begin; antenna != end; ++antenna) {
+        // Eigen stores fixed-size matrices contiguously
+        seed = GuidingCache::hash(antenna->position().data(), 3 * sizeof(Float), seed);
+        seed = GuidingCache::hash(antenna->rotation().data(), 9 * sizeof(Float), seed);
+
+        // the guiding distribution is learned in the primary sample space of the radiation pattern
+        if (const TabulatedAngularDistribution *pattern = antenna->pattern()) {
+            const size_t size = size_t(pattern->resolution()) * pattern->resolution();
+            seed = GuidingCache::hash(pattern->gains(), size * sizeof(Float), seed);
+        }
+    }
+    return seed;
+}
+
+}
+
+GuidingCache::GuidingCache(const std::string &directory, const TriangleMesh &mesh)
+: m_directory(directory) {
+    m_meshHash = hash(mesh.vertexBuffer.data(), mesh.vertexBuffer.size() * sizeof(Vector3f));
+    m_meshHash = hash(mesh.indexBuffer.data(), mesh.indexBuffer.size() * sizeof(TriangleMesh::IndexTriplet), m_meshHash);
+
+    // motions shift the frequencies of paths, and hence what guiding learns
+    for (const TriangleMesh::Motion &motion : mesh.motionBuffer) {
+        m_meshHash = hash(motion.linearVelocity.data(), 3 * sizeof(Float), m_meshHash);
+        m_meshHash = hash(motion.angularVelocity.data(), 3 * sizeof(Float), m_meshHash);
+        m_meshHash = hash(motion.center.data(), 3 * sizeof(Float), m_meshHash);
+    }
+    const std::vector<int> motionIndices = mesh.motionIndices();
+    m_meshHash = hash(motionIndices.data(), motionIndices.size() * sizeof(int), m_meshHash);
+}
+
+uint64_t GuidingCache::key(const Scene &scene, uint64_t settings) const {
+    const int counts[] = { scene.tx.size(), scene.rx.size() };
+    const radar::RFConfig &rf = scene.rfConfig;
+    const Float rfFields[] = { rf.startFreq, rf.freqSlope, rf.adcRate, rf.idleTime, rf.rampTime, rf.antennaDelay };
+
+    uint64_t result = hash(counts, sizeof(counts), m_meshHash);
+    result = hash(&settings, sizeof(settings), result);
+    result = hash(rfFields, sizeof(rfFields), result);
+    result = hashAntennas(scene.tx.begin(), scene.tx.end(), result);
+    return hashAntennas(scene.rx.begin(), scene.rx.end(), result);
+}
+
+bool GuidingCache::load(uint64_t key, Entry &entry) const {
+    std::ifstream file(path(key), std::ios::binary);
+    if (!file)
+        return false;
+
+    FileHeader header;
+    if (!file.read((char *)&header, sizeof(header)) ||
+        std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+        header.key != key ||
+        header.transmitterCount > Scene::MaxTransmitters ||
+        header.resolution == 0 || header.resolution > MaxResolution) {
+        Log(EWarn, "ignoring malformed guiding cache entry %016llx", (unsigned long long)key);
+        return false;
+    }
+
+    // the tables must exactly fill the remainder of the file
+    const uint64_t tableSize = uint64_t(header.resolution) * header.resolution * sizeof(Float);
+    file.seekg(0, std::ios::end);
+    const uint64_t fileSize = uint64_t(file.tellg());
+    file.seekg(sizeof(header));
+    if (!file || fileSize != sizeof(header) + header.transmitterCount * tableSize) {
+        Log(EWarn, "ignoring truncated guiding cache entry %016llx", (unsigned long long)key);
+        return false;
+    }
+
+    entry.resolution = int(header.resolution);
+    entry.uniformProb = header.uniformProb;
+    entry.densities.resize(header.transmitterCount);
+    for (auto &table : entry.densities) {
+        table.resize(size_t(header.resolution) * header.resolution);
+        if (!file.read((char *)table.data(), table.size() * sizeof(Float))) {
+            Log(EWarn, "ignoring truncated guiding cache entry %016llx", (unsigned long long)key);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void GuidingCache::store(uint64_t key, const Entry &entry) const {
+    FileHeader header = {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.key = key;
+    header.resolution = uint32_t(entry.resolution);
+    header.transmitterCount = uint32_t(entry.densities.size());
+    header.uniformProb = entry.uniformProb;
+
+    // write to a temporary file first, so that concurrent readers never see partial entries
+    const std::string target = path(key);
+    const std::string temporary = target + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write((const char *)&header, sizeof(header));
+        for (const auto &table : entry.densities) {
+            assert(table.size() == size_t(entry.resolution) * entry.resolution);
+            file.write((const char *)table.data(), table.size() * sizeof(Float));
+        }
+
+        if (!file) {
+            Log(EWarn, "could not write guiding cache entry %s", temporary.c_str());
+            return;
+        }
+    }
+
+    if (std::rename(temporary.c_str(), target.c_str()) != 0)
+        Log(EWarn, "could not write guiding cache entry %s", target.c_str());
+}
+
+uint64_t GuidingCache::hash(const void *data, size_t size, uint64_t seed) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < size; ++i) {
+        seed ^= bytes[i];
+        seed *= 0x100000001b3ull;
+    }
+    return seed;
+}
+
+std::string GuidingCache::path(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.guide", (unsigned long long)key);
+    return m_directory + "/" + name;
+}
+
+}
@@ -0,0 +1,81 @@
+#include <hussar/io/pattern.h>
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+namespace hussar {
+
+namespace {
+
+struct Measurement {
+    Float azimuth, elevation, gain;
+};
+
+/// Returns the distinct values of a coordinate (up to rounding errors of the measurement setup).
+std::vector<Float> distinct(std::vector<Float> values) {
+    std::sort(values.begin(), values.end());
+    std::vector<Float> result;
+    for (Float value : values) {
+        if (result.empty() || value - result.back() > Float(1e-3))
+            result.push_back(value);
+    }
+    return result;
+}
+
+}
+
+TabulatedAngularDistribution loadAntennaPattern(const std::string &path, int resolution) {
+    std::ifstream file(path);
+    if (!file)
+        throw PatternError("could not open " + path);
+
+    std::vector<Measurement> measurements;
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        const size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+
+        Measurement measurement;
+        if (!(fields >> measurement.azimuth >> measurement.elevation >> measurement.gain))
+            throw PatternError(path + ":" + std::to_string(number) + " is not a measurement");
+        measurements.push_back(measurement);
+    }
+
+    std::vector<Float> azimuths, elevations;
+    for (const Measurement &measurement : measurements) {
+        azimuths.push_back(measurement.azimuth);
+        elevations.push_back(measurement.elevation);
+    }
+    azimuths = distinct(azimuths);
+    elevations = distinct(elevations);
+
+    const int azimuthCount = int(azimuths.size()), elevationCount = int(elevations.size());
+    if (azimuthCount < 2 || elevationCount < 2 || measurements.size() != size_t(azimuthCount) * elevationCount)
+        throw PatternError(path + " does not describe a regular grid of directions");
+    if (std::abs(azimuths.front() + 180) > 1e-2f || std::abs(azimuths.back() - 180) > 1e-2f ||
+        std::abs(elevations.front() + 90) > 1e-2f || std::abs(elevations.back() - 90) > 1e-2f)
+        throw PatternError(path + " does not cover the entire sphere");
+
+    const Float azimuthStep = 360 / Float(azimuthCount - 1), elevationStep = 180 / Float(elevationCount - 1);
+    std::vector<Float> gains(measurements.size(), -1);
+    for (const Measurement &measurement : measurements) {
+        const Float x = (measurement.azimuth + 180) / azimuthStep, y = (measurement.elevation + 90) / elevationStep;
+        const int i = int(std::round(x)), j = int(std::round(y));
+        if (std::abs(x - i) > 1e-2f || std::abs(y - j) > 1e-2f || gains[size_t(i) * elevationCount + j] >= 0)
+            throw PatternError(path + " does not describe a regular grid of directions");
+
+        // measurements are power gains in dB, while the distribution tabulates the gain of the field amplitude
+        gains[size_t(i) * elevationCount + j] = std::pow(Float(10), measurement.gain / 20);
+    }
+
+    return TabulatedAngularDistribution(gains.data(), azimuthCount, elevationCount, resolution);
+}
+
+}
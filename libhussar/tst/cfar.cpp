@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/frame.h>
+#include <radar/cfar.h>
+
+#include <random>
+
+namespace hussar {
+
+namespace {
+
+/// A frame (in Fourier space) with complex Gaussian noise of unit power and two strong targets.
+RadarFrame noisyFrame(const radar::FrameConfig &config, int seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<Float> normal(0, std::sqrt(Float(0.5)));
+
+    RadarFrame frame;
+    frame.configure(config);
+    for (size_t s = 0; s < frame.sampleCount(); ++s)
+        frame(s) = Complex(normal(rng), normal(rng));
+
+    RadarFrame::Index a, b;
+    a.chirp = 3; a.sample = 10; a.channel = 1;
+    b.chirp = 12; b.sample = 40; b.channel = 3;
+    frame(a) = 40;
+    frame(b) = 20;
+    return frame;
+}
+
+}
+
+// Both CA-CFAR and OS-CFAR should find exactly the two targets in every frame
+TEST(CFARTest, finds_targets) {
+    radar::FrameConfig config;
+    config.chirpCount      = 16;
+    config.samplesPerChirp = 64;
+    config.channelCount    = 4;
+
+    radar::RFConfig rf = {};
+    rf.startFreq = 77e9;
+    rf.freqSlope = 60e12;
+    rf.adcRate   = 5e6;
+    rf.idleTime  = 100e-6;
+    rf.rampTime  = 60e-6;
+
+    const RadarFrame frames[] = { noisyFrame(config, 1), noisyFrame(config, 2) };
+
+    for (auto method : { radar::CFARMethod::CellAveraging, radar::CFARMethod::OrderedStatistic }) {
+        radar::CFARConfig cfarConfig;
+        cfarConfig.method = method;
+
+        radar::CFARDetector detector;
+        detector.configure(config, rf, cfarConfig);
+        EXPECT_EQ(detector.trainingCellCount(), 13 * 21 - 5 * 5);
+
+        auto detections = detector.detect(frames, 2, [](auto &&task) {
+            task(0);
+            task(1);
+        });
+        ASSERT_EQ(detections.size(), 4u);
+
+        for (int i = 0; i < 4; ++i) {
+            const auto &detection = detections[i];
+            EXPECT_EQ(detection.frame, i / 2);
+
+            const bool first = i % 2 == 0;
+            EXPECT_NEAR(detection.chirp, first ? 3 : 12, 0.5);
+            EXPECT_NEAR(detection.sample, first ? 10 : 40, 0.5);
+            EXPECT_NEAR(detection.channel, first ? 1 : 3, 0.5);
+            EXPECT_GT(detection.snr, 15);
+        }
+    }
+}
+
+}
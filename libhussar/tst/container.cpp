@@ -0,0 +1,157 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/frame.h>
+#include <radar/container.h>
+
+#include <random>
+#include <fstream>
+#include <filesystem>
+#include <cstdio>
+#include <cstddef>
+#include <functional>
+
+namespace hussar {
+
+namespace {
+
+radar::FrameConfig testConfig() {
+    radar::FrameConfig config;
+    config.chirpCount      = 3;
+    config.samplesPerChirp = 5;
+    config.channelCount    = 3; // frames are not a multiple of the alignment
+    return config;
+}
+
+}
+
+// Frames, tags and configurations should survive a roundtrip, with uncompressed frames accessible in-place
+TEST(ContainerTest, roundtrip) {
+    radar::RFConfig rf = {};
+    rf.startFreq = 77e9;
+    rf.adcRate   = 5e6;
+
+    const radar::FrameConfig config = testConfig();
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<Float> uniform(-1, 1);
+    std::vector<RadarFrame> frames(7);
+    for (auto &frame : frames) {
+        frame.configure(config);
+        for (size_t s = 0; s < frame.sampleCount(); ++s)
+            frame(s) = Complex(uniform(rng), uniform(rng));
+    }
+
+    const std::string path = std::filesystem::temp_directory_path() / "container_test.rcube";
+    {
+        radar::ContainerOptions options;
+        options.framesPerChunk = 3;
+
+        radar::ContainerWriter writer(path, rf, config, options);
+        for (size_t i = 0; i < frames.size(); ++i)
+            writer.write(frames[i], 0.5 * i);
+        EXPECT_EQ(writer.frameCount(), int(frames.size()));
+    }
+
+    {
+        radar::ContainerReader reader(path);
+        EXPECT_EQ(reader.frameCount(), int(frames.size()));
+        EXPECT_EQ(reader.rfConfig().startFreq, rf.startFreq);
+        EXPECT_EQ(reader.frameConfig().channelCount, config.channelCount);
+
+        for (int i = int(frames.size()) - 1; i >= 0; --i) {
+            EXPECT_EQ(reader.tag(i), 0.5 * i);
+
+            const radar::Complex *data = reader.frame(i);
+            ASSERT_NE(data, nullptr);
+            EXPECT_EQ(uintptr_t(data) % radar::container::Alignment, 0u);
+
+            RadarFrame frame;
+            reader.read(i, frame);
+            for (size_t s = 0; s < frame.sampleCount(); ++s) {
+                EXPECT_EQ(std::abs(data[s] - frames[i](s)), 0);
+                EXPECT_EQ(std::abs(frame(s) - frames[i](s)), 0);
+            }
+        }
+    }
+
+    std::remove(path.c_str());
+    EXPECT_THROW(radar::ContainerReader reader(path), radar::ContainerError);
+}
+
+namespace {
+
+/// Writes a container of two frames, overwrites some bytes of it and returns whether reading it is rejected.
+bool rejectsCorruption(const std::function<void (std::fstream &file)> &corrupt) {
+    const radar::FrameConfig config = testConfig();
+    RadarFrame frame;
+    frame.configure(config);
+    frame.clear();
+
+    const std::string path = std::filesystem::temp_directory_path() / "container_malformed.rcube";
+    {
+        radar::ContainerWriter writer(path, {}, config);
+        writer.write(frame);
+        writer.write(frame);
+    }
+
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        corrupt(file);
+    }
+
+    bool isRejected = false;
+    try {
+        radar::ContainerReader reader(path);
+    } catch (const radar::ContainerError &) {
+        isRejected = true;
+    }
+    std::remove(path.c_str());
+    return isRejected;
+}
+
+/// Returns the offset of the index of a container.
+uint64_t indexOffset(std::fstream &file) {
+    uint64_t offset;
+    file.seekg(-std::streamoff(sizeof(radar::container::FileFooter)), std::ios::end);
+    file.read((char *)&offset, sizeof(offset));
+    return offset;
+}
+
+}
+
+// Indices that refer to chunks or data which do not exist should be rejected
+TEST(ContainerTest, rejects_malformed_index) {
+    // the last frame entry directly precedes the footer
+    EXPECT_TRUE(rejectsCorruption([](std::fstream &file) {
+        file.seekp(-std::streamoff(sizeof(radar::container::FileFooter) + sizeof(radar::container::FrameEntry)), std::ios::end);
+        const uint32_t chunk = 7;
+        file.write((const char *)&chunk, sizeof(chunk));
+    }));
+
+    // an index offset that wraps around when the size of the index is added
+    EXPECT_TRUE(rejectsCorruption([](std::fstream &file) {
+        file.seekp(-std::streamoff(sizeof(radar::container::FileFooter)), std::ios::end);
+        const uint64_t offset = ~uint64_t(0) - 15;
+        file.write((const char *)&offset, sizeof(offset));
+    }));
+
+    // a chunk whose end wraps around
+    EXPECT_TRUE(rejectsCorruption([](std::fstream &file) {
+        file.seekp(indexOffset(file));
+        const uint64_t offset = ~uint64_t(0) - 15;
+        file.write((const char *)&offset, sizeof(offset));
+    }));
+
+    // a frame without samples
+    EXPECT_TRUE(rejectsCorruption([](std::fstream &file) {
+        file.seekp(offsetof(radar::container::FileHeader, frame));
+        const int32_t extent = -3;
+        file.write((const char *)&extent, sizeof(extent));
+    }));
+
+    // an unmodified container is accepted
+    EXPECT_FALSE(rejectsCorruption([](std::fstream &) {}));
+}
+
+}
@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/frame.h>
+#include <radar/dataset.h>
+
+#include <random>
+#include <fstream>
+#include <filesystem>
+#include <cstdio>
+
+namespace hussar {
+
+// Comparing a raw sweep with a scaled container of the same frames at shifted angles should align
+// the frames by angle and yield perfect agreement once calibrated
+TEST(DatasetTest, compares_sweeps) {
+    radar::RFConfig rf = {};
+
+    radar::FrameConfig config;
+    config.chirpCount      = 1;
+    config.samplesPerChirp = 37;
+    config.channelCount    = 1;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<Float> uniform(-1, 1);
+    std::vector<RadarFrame> frames(6);
+    for (size_t f = 0; f < frames.size(); ++f) {
+        frames[f].configure(config);
+        for (size_t s = 0; s < config.sampleCount(); ++s)
+            frames[f](s) = Complex(uniform(rng), uniform(rng));
+
+        RadarFrame::Index peak;
+        peak.sample = int(f) * 5;
+        frames[f](peak) = 10;
+    }
+
+    // the measured sweep covers angles -10, -8, ..., +0
+    const std::filesystem::path directory = std::filesystem::temp_directory_path();
+    const std::string rawPath = directory / "dataset_test.raw", containerPath = directory / "dataset_test.rcube";
+    {
+        std::ofstream file(rawPath, std::ios::binary);
+        for (const auto &frame : frames)
+            file.write((const char *)frame.data(), frame.sampleCount() * sizeof(radar::Complex));
+    }
+
+    // the simulated sweep covers angles in reverse order at twice the magnitude
+    {
+        radar::ContainerWriter writer(containerPath, rf, config);
+        for (int f = int(frames.size()) - 1; f >= 0; --f) {
+            RadarFrame scaled = frames[f];
+            scaled *= 2;
+            writer.write(scaled, -10 + 2 * f + 0.1);
+        }
+    }
+
+    {
+        radar::Dataset measurement(rawPath, config, -10, 2);
+        radar::Dataset simulation(containerPath);
+        ASSERT_EQ(measurement.frameCount(), int(frames.size()));
+
+        radar::ComparisonOptions options;
+        options.scale = 0.5;
+        options.tolerance = 0.5;
+        auto comparison = radar::compare(measurement, simulation, options, [](auto &&task) {
+            task(0);
+            task(1);
+        });
+
+        ASSERT_EQ(comparison.frames.size(), frames.size());
+        for (size_t f = 0; f < frames.size(); ++f) {
+            EXPECT_EQ(comparison.frames[f].reference, int(frames.size() - 1 - f));
+            EXPECT_NEAR(comparison.frames[f].magnitudeError, 0, 1e-5);
+            EXPECT_NEAR(comparison.frames[f].correlation, 1, 1e-5);
+        }
+        EXPECT_NEAR(comparison.peakDistance, 0, 1e-5);
+        for (Float error : comparison.binError)
+            EXPECT_NEAR(error, 0, 1e-5);
+
+        // without calibration, the magnitudes differ but remain perfectly correlated
+        comparison = radar::compare(measurement, simulation);
+        EXPECT_GT(comparison.magnitudeError, 0.5);
+        EXPECT_NEAR(comparison.correlation, 1, 1e-5);
+    }
+
+    std::remove(rawPath.c_str());
+    std::remove(containerPath.c_str());
+}
+
+}
@@ -0,0 +1,103 @@
+#ifndef HUSSAR_TST_DIHEDRAL_H
+#define HUSSAR_TST_DIHEDRAL_H
+
+#include <hussar/hussar.h>
+#include <hussar/core/scene.h>
+#include <hussar/core/emitter.h>
+#include <hussar/core/intersection.h>
+#include <radar/units.h>
+
+#include <cmath>
+
+namespace hussar {
+
+/// Traces rays against a dihedral corner reflector made of two squares with an edge length of 5 cm.
+struct DihedralRT {
+    bool hitPlane(const Intersection &isect, int axis, Float &t) const {
+        const Float d = isect.ray.d[axis];
+        if (std::abs(d) < 1e-8f)
+            return false;
+
+        t = -isect.ray.o[axis] / d;
+        if (t <= 1e-4f || t >= isect.tMax)
+            return false;
+
+        const Vector3f p = isect.ray(t);
+        for (int other = 0; other < 3; ++other)
+            if (other != axis && (p[other] < 0 || p[other] > Float(0.05)))
+                return false;
+        return true;
+    }
+
+    void intersect(Intersection &isect) const {
+        Float closest = isect.tMax;
+        int hit = -1;
+        for (int axis : { 0, 2 }) {
+            Float t;
+            if (hitPlane(isect, axis, t) && t < closest) {
+                closest = t;
+                hit = axis;
+            }
+        }
+        if (hit < 0)
+            return;
+
+        isect.t = closest;
+        isect.p = isect.ray(closest);
+        isect.n = Vector3f::Zero();
+        isect.n[hit] = 1;
+        if (isect.n.dot(isect.ray.d) > 0)
+            isect.n = -isect.n;
+    }
+
+    bool visible(Intersection &isect) const {
+        Intersection occluder = isect;
+        occluder.t = Infinity;
+        intersect(occluder);
+        return !occluder.valid();
+    }
+
+    void visible(Intersection *const *isects, bool *results, size_t count) const {
+        for (size_t i = 0; i < count; ++i)
+            results[i] = visible(*isects[i]);
+    }
+
+    void intersect(Intersection *const *isects, size_t count) const {
+        for (size_t i = 0; i < count; ++i)
+            intersect(*isects[i]);
+    }
+};
+
+/// A small frame, which suffices to compare simulations of the dihedral reflector.
+inline radar::FrameConfig dihedralFrameConfig() {
+    radar::FrameConfig config;
+    config.chirpCount = 1;
+    config.samplesPerChirp = 64;
+    config.channelCount = 1;
+    return config;
+}
+
+/// Places one transmit and one receive antenna in front of the dihedral reflector (see `DihedralRT`).
+inline Scene dihedralScene() {
+    radar::RFConfig rf;
+    rf.startFreq = 77_GHz;
+    rf.freqSlope = 60_MHz / 1_us;
+    rf.adcRate = 5_MHz;
+    rf.idleTime = 100_us;
+    rf.rampTime = 60_us;
+    rf.antennaDelay = 0.43_ns;
+
+    const Matrix33f rotation = Eigen::AngleAxisf(-Pi / 4, Vector3f::UnitY()).toRotationMatrix();
+    Matrix33f facing;
+    facing << 0, 0, -1, 0, -1, 0, -1, 0, 0;
+
+    Scene scene;
+    scene.rfConfig = rf;
+    scene.tx = { NFAntenna { rotation * Vector3f(0.896f, 0.025f, -0.007f), rotation * facing, AWRAngularDistribution() } };
+    scene.rx = { NFAntenna { rotation * Vector3f(0.896f, 0.025f, -0.005f), rotation * facing, AWRAngularDistribution() } };
+    return scene;
+}
+
+}
+
+#endif
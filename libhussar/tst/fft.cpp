@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/frame.h>
+#include <radar/fft.h>
+
+#include <random>
+
+namespace hussar {
+
+// A forward transform followed by a backward transform should scale the data by its size,
+// including when cached plans are reused for other frames of the same configuration
+TEST(FFTTest, roundtrip) {
+    radar::FrameConfig config;
+    config.chirpCount      = 6;
+    config.samplesPerChirp = 16;
+    config.channelCount    = 3;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<Float> uniform(-1, 1);
+
+    for (int run = 0; run < 2; ++run) {
+        RadarFrame frame, reference;
+        frame.configure(config);
+        for (size_t s = 0; s < frame.sampleCount(); ++s)
+            frame(s) = Complex(uniform(rng), uniform(rng));
+        reference = frame;
+
+        frame.fft();
+        radar::fft::transform(&frame(size_t(0)), config.raw, config.NUM_COMPONENTS, +1);
+
+        const Float norm = Float(1) / frame.sampleCount();
+        for (size_t s = 0; s < frame.sampleCount(); ++s) {
+            EXPECT_NEAR(frame(s).real() * norm, reference(s).real(), 1e-4);
+            EXPECT_NEAR(frame(s).imag() * norm, reference(s).imag(), 1e-4);
+        }
+    }
+}
+
+// Transforming all axes at once should match transforming one axis after another
+TEST(FFTTest, matches_axes) {
+    radar::FrameConfig config;
+    config.chirpCount      = 4;
+    config.samplesPerChirp = 10;
+    config.channelCount    = 2;
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<Float> uniform(-1, 1);
+
+    RadarFrame frame, reference;
+    frame.configure(config);
+    for (size_t s = 0; s < frame.sampleCount(); ++s)
+        frame(s) = Complex(uniform(rng), uniform(rng));
+    reference = frame;
+
+    frame.fft();
+    for (int axis = 0; axis < config.NUM_COMPONENTS; ++axis)
+        radar::fft::transformAxis(&reference(size_t(0)), config.raw, config.NUM_COMPONENTS, axis, -1);
+
+    for (size_t s = 0; s < frame.sampleCount(); ++s)
+        EXPECT_LT(std::abs(frame(s) - reference(s)), 1e-3);
+}
+
+}
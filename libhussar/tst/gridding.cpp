@@ -0,0 +1,73 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/frame.h>
+#include <radar/gridding.h>
+
+#include <random>
+#include <complex>
+
+namespace hussar {
+
+namespace {
+
+/// The response of a rectangular window to a contribution at fractional bin `f` (evaluated at bin `k`).
+std::complex<double> dirichlet(double f, int k, int count) {
+    std::complex<double> sum = 0;
+    for (int n = 0; n < count; ++n)
+        sum += std::exp(std::complex<double>(0, 2 * M_PI * (f - k) * n / count));
+    return sum / double(count);
+}
+
+}
+
+// The gridder should reproduce the exact response of fractional contributions across all bins
+TEST(GridderTest, matches_dirichlet) {
+    radar::FrameConfig config;
+    config.chirpCount      = 8;
+    config.samplesPerChirp = 64;
+    config.channelCount    = 2;
+
+    const bool gridded[] = { true, true, false };
+    radar::Gridder<> gridder;
+    gridder.configure(config, gridded);
+
+    RadarFrame result, reference;
+    result.configure(config);
+    result.clear();
+    reference.configure(config);
+    reference.clear();
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<Float> uniform(0, 1);
+    for (int i = 0; i < 20; ++i) {
+        RadarFrame::PIndex index;
+        index.chirp   = uniform(rng) * config.chirpCount;
+        index.sample  = uniform(rng) * config.samplesPerChirp;
+        index.channel = i % config.channelCount;
+
+        Complex value = radar::polar(Float(1), 2 * Pi * uniform(rng));
+        gridder.splat(index, value);
+
+        for (size_t s = 0; s < reference.sampleCount(); ++s) {
+            auto bin = reference.makeIndex(s);
+            if (bin.channel != index.channel)
+                continue;
+
+            auto d = dirichlet(index.chirp, bin.chirp, config.chirpCount) *
+                dirichlet(index.sample, bin.sample, config.samplesPerChirp);
+            reference(s) += Complex(d.real(), d.imag()) * value;
+        }
+    }
+
+    gridder.resolve(result);
+
+    double error = 0, norm = 0;
+    for (size_t s = 0; s < reference.sampleCount(); ++s) {
+        error += std::pow(std::abs(result(s) - reference(s)), 2);
+        norm  += std::pow(std::abs(reference(s)), 2);
+    }
+    EXPECT_LT(std::sqrt(error / norm), 1e-4);
+}
+
+}
@@ -0,0 +1,245 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/emitter.h>
+#include <hussar/integrators/path.h>
+#include <radar/units.h>
+
+#include "dihedral.h"
+
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace hussar {
+
+using GuidingTree = GuidingWrapper<
+    guiding::BTree<2, guiding::Leaf<guiding::Empty>, guiding::Empty, Allocator>
+>;
+
+/// A deterministic point of the unit square for a sample index.
+static Vector2f samplePoint(long index) {
+    uint64_t state = uint64_t(index) * 6364136223846793005ull + 1442695040888963407ull;
+    const auto next = [&]() {
+        state ^= state >> 33;
+        state *= 0xff51afd7ed558ccdull;
+        state ^= state >> 33;
+        return Float(state >> 40) / Float(1ull << 24);
+    };
+    const Float u = next();
+    return Vector2f(u, next());
+}
+
+/// Trains a distribution with the samples [0, sampleCount), which are recorded by the given amount of workers.
+static std::vector<Float> train(int workerCount, long sampleCount) {
+    GuidingTree tree;
+    tree.prepareWorkers(workerCount);
+
+    const auto parallel = [&](const std::function<void (int)> &task) {
+        std::vector<std::thread> threads;
+        for (int worker = 0; worker < workerCount; ++worker)
+            threads.emplace_back(task, worker);
+        for (std::thread &thread : threads)
+            thread.join();
+    };
+
+    for (int iteration = 0; iteration < 2; ++iteration) {
+        // workers record interleaved samples in descending order, unlike a single worker
+        parallel([&](int worker) {
+            for (long index = sampleCount - 1; index >= 0; --index) {
+                if (index % workerCount != worker)
+                    continue;
+
+                const Vector2f x = samplePoint(index);
+                const Float density = 1 + 8 * x[0] * x[1];
+                tree.record(worker, index, density, {}, Float(1) / (index % 3 + 1), x);
+            }
+        });
+
+        tree.merge(parallel);
+        tree.step();
+    }
+
+    return tree.tabulate(32);
+}
+
+TEST(GuidingTest, independent_of_worker_count) {
+    const std::vector<Float> reference = train(1, 20000);
+    for (int workerCount : { 2, 3, 8 }) {
+        const std::vector<Float> result = train(workerCount, 20000);
+        ASSERT_EQ(result.size(), reference.size());
+        for (size_t i = 0; i < reference.size(); ++i)
+            EXPECT_EQ(result[i], reference[i]) << "with " << workerCount << " workers at cell " << i;
+    }
+}
+
+// Seeding from the previous pose of an antenna must preserve the density of each direction
+TEST(GuidingTest, seeds_from_previous_pose) {
+    const AWRAngularDistribution awr;
+    const TabulatedAngularDistribution pattern([&](const Vector3f &d) {
+        return Float(awr.evaluate(d).norm() / Vector3f(0, 1, 0).cross(d).norm());
+    }, 64);
+
+    const NFAntenna previous(Vector3f(0, 0, 0), Matrix33f::Identity(), pattern);
+    const NFAntenna current(Vector3f(0, 0, 0), Matrix33f(Eigen::AngleAxisf(0.5f, Vector3f(0, 1, 0))), pattern);
+
+    // a density over the samples of the previous pose
+    const auto density = [](const Vector2f &y) {
+        return 4 * y[0] * y[1];
+    };
+
+    const int n = 256;
+    double integral = 0;
+    for (int a = 0; a < n; ++a) {
+        for (int b = 0; b < n; ++b) {
+            const Vector2f x((a + 0.5f) / n, (b + 0.5f) / n);
+
+            Float jacobian;
+            const Vector2f y = PathTracer::seedSample(current, previous, x, jacobian);
+            integral += density(y) * jacobian / (n * n);
+
+            // an unchanged pose maps samples to themselves
+            const Vector2f same = PathTracer::seedSample(previous, previous, x, jacobian);
+            EXPECT_NEAR(same[0], x[0], 1e-3);
+            EXPECT_NEAR(same[1], x[1], 1e-3);
+            EXPECT_NEAR(jacobian, 1, 1e-3);
+        }
+    }
+
+    // the seeded density remains normalized
+    EXPECT_NEAR(integral, 1, 1e-2);
+}
+
+// Iterations are weighted by their inverse variance, and training stops once the variance stagnates
+TEST(GuidingTest, combines_iterations_by_inverse_variance) {
+    PathTracer::TrainingSchedule schedule;
+    schedule.combineIterations = true;
+    schedule.minVarianceReduction = 0.1f;
+
+    const double variances[] = { 8, 4, 2, 1.9, 1 };
+    const Float weights[] = { 1, 2, 4, Float(8 / 1.9) };
+
+    PathTracer::TrainingProgress progress;
+    int iteration = 0;
+    while (true) {
+        EXPECT_FLOAT_EQ(progress.record(schedule, variances[iteration]), weights[iteration]);
+        EXPECT_FLOAT_EQ(progress.iterationWeight, weights[iteration]);
+        if (progress.hasConverged)
+            break;
+        ++iteration;
+    }
+
+    // the fourth iteration reduces the variance by only 5%
+    EXPECT_EQ(iteration, 3);
+
+    // iterations are not combined unless requested, but convergence is still tracked
+    schedule.combineIterations = false;
+    progress = PathTracer::TrainingProgress();
+    EXPECT_EQ(progress.record(schedule, 8), 0);
+    EXPECT_EQ(progress.record(schedule, 7.5), 0);
+    EXPECT_TRUE(progress.hasConverged);
+    EXPECT_EQ(progress.iterationWeight, 1);
+}
+
+/// Samples on several threads, each taking every n-th sample (like the CPU backend, but without Embree).
+struct ThreadedBackend {
+    PathTracer &integrator;
+    int workerCount;
+    DihedralRT rt;
+
+    struct Session {};
+    Session session() { return {}; }
+
+    void parallel(const std::function<void (int)> &task) {
+        std::vector<std::thread> threads;
+        for (int worker = 0; worker < workerCount; ++worker)
+            threads.emplace_back(task, worker);
+        for (std::thread &thread : threads)
+            thread.join();
+    }
+
+    void run(const Scene &scene, long budget, bool * = nullptr) {
+        integrator.prepareWorkers(workerCount);
+        parallel([&](int worker) {
+            integrator.runBackgroundTasks();
+            for (long index = worker; index < budget; index += workerCount)
+                integrator.sample(scene, rt, index, worker);
+        });
+        integrator.reduceWorkers([&](const std::function<void (int)> &task) { parallel(task); });
+    }
+};
+
+// Rebuilding guiding on the workers must not make the result depend on timing
+TEST(GuidingTest, async_rebuild_is_reproducible) {
+    const radar::FrameConfig config = dihedralFrameConfig();
+    const Scene scene = dihedralScene();
+
+    const auto simulate = [&]() {
+        PathTracer integrator;
+        integrator.configureFrame(config);
+        integrator.perThreadFrames = true; // keeps the order of floating point additions fixed
+        integrator.asyncGuidingRebuild = true;
+        integrator.schedule.initialSamples = 4096;
+
+        ThreadedBackend backend { integrator, 4 };
+        integrator.run(backend, scene, 50000);
+        return integrator.fetchFrame();
+    };
+
+    const RadarFrame reference = simulate();
+    for (int repetition = 0; repetition < 3; ++repetition) {
+        const RadarFrame result = simulate();
+        for (size_t i = 0; i < reference.sampleCount(); ++i) {
+            ASSERT_EQ(result(i).real(), reference(i).real()) << "at sample " << i;
+            ASSERT_EQ(result(i).imag(), reference(i).imag()) << "at sample " << i;
+        }
+    }
+}
+
+// One-sample MIS of primary directions must report the density it samples with
+TEST(GuidingTest, primary_sampling_pdf) {
+    const AWRAngularDistribution awr;
+    const TabulatedAngularDistribution pattern([&](const Vector3f &d) {
+        return Float(awr.evaluate(d).norm() / Vector3f(0, 1, 0).cross(d).norm());
+    }, 64);
+    const NFAntenna antenna(Vector3f(0, 0, 0), Matrix33f(Eigen::AngleAxisf(0.3f, Vector3f(1, 0, 0))), pattern);
+
+    GuidingTree tree;
+    tree.settings.uniformProb = 0;
+    tree.fit([](const Vector2f &x) { return 1 + 4 * x[0] * x[1]; });
+
+    Float selection[PathTracer::PrimaryStrategyCount];
+    selection[PathTracer::PatternStrategy] = 0.3f;
+    selection[PathTracer::GuidedStrategy] = 0.5f;
+    selection[PathTracer::UniformStrategy] = 0.2f;
+
+    const int n = 128;
+    Float pdfs[PathTracer::PrimaryStrategyCount];
+    for (int a = 0; a < n; ++a) {
+        for (int b = 0; b < n; ++b) {
+            Vector2f x((a + 0.5f) / n, (b + 0.5f) / n);
+            Ray ray;
+            const Float pdf = PathTracer::samplePrimary(
+                antenna, tree, selection, PathTracer::MISHeuristic::Balance, x, ray, pdfs);
+            if (pdf == 0)
+                continue;
+
+            // the density of the sample is that of its direction, regardless of the strategy that produced it
+            const Float evaluated = PathTracer::primaryPdf(antenna, tree, selection, antenna.invert(ray.d), ray.d, pdfs);
+            EXPECT_NEAR(pdf, evaluated, 1e-2f * evaluated) << "for sample " << a << ", " << b;
+        }
+    }
+
+    // converted to solid angle, the density integrates to one over the sphere
+    double integral = 0;
+    for (int a = 0; a < n; ++a) {
+        for (int b = 0; b < n; ++b) {
+            const Vector3f d = UniformSampleSphere(Vector2f((a + 0.5f) / n, (b + 0.5f) / n));
+            const Float density = PathTracer::primaryPdf(antenna, tree, selection, antenna.invert(d), d, pdfs);
+            integral += density * antenna.pdf(d) / UniformSpherePdf() / (n * n);
+        }
+    }
+    EXPECT_NEAR(integral, 1, 1e-2);
+}
+
+}
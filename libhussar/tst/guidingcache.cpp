@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/mesh.h>
+#include <hussar/core/scene.h>
+#include <hussar/io/guidingcache.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace hussar {
+
+// Entries should be found again for the same configuration, but not once an antenna has moved
+TEST(GuidingCacheTest, stores_entries_by_pose) {
+    TriangleMesh mesh;
+    mesh.addBox(Vector3f(0, 0, 0), Vector3f(1, 1, 1));
+
+    const std::string directory = std::filesystem::temp_directory_path() / "hussar-guiding-cache";
+    std::filesystem::create_directories(directory);
+    GuidingCache cache(directory, mesh);
+
+    Scene scene;
+    scene.rfConfig = { 77e9, 60e12, 5e6, 100e-6, 60e-6, 0 };
+    scene.tx = { NFAntenna { Vector3f(0, 0, -1), Matrix33f::Identity(), AWRAngularDistribution() } };
+    scene.rx = { NFAntenna { Vector3f(0, 0, -1), Matrix33f::Identity(), AWRAngularDistribution() } };
+
+    GuidingCache::Entry entry;
+    entry.resolution = 4;
+    entry.uniformProb = 0.1f;
+    entry.densities.push_back(std::vector<Float>(16));
+    for (int i = 0; i < 16; ++i)
+        entry.densities[0][i] = Float(i);
+
+    const uint64_t key = cache.key(scene, 1);
+    cache.store(key, entry);
+
+    GuidingCache::Entry loaded;
+    ASSERT_TRUE(cache.load(key, loaded));
+    EXPECT_EQ(loaded.resolution, entry.resolution);
+    EXPECT_EQ(loaded.uniformProb, entry.uniformProb);
+    ASSERT_EQ(loaded.densities.size(), 1u);
+    EXPECT_EQ(loaded.densities[0], entry.densities[0]);
+
+    // different settings of the integrator train different distributions
+    EXPECT_NE(cache.key(scene, 2), key);
+
+    scene.tx[0].position().x() += 0.01f;
+    EXPECT_NE(cache.key(scene, 1), key);
+    EXPECT_FALSE(cache.load(cache.key(scene, 1), loaded));
+
+    std::filesystem::remove_all(directory);
+}
+
+// Entries whose size does not match their header must be rejected
+TEST(GuidingCacheTest, rejects_malformed_entries) {
+    TriangleMesh mesh;
+    mesh.addBox(Vector3f(0, 0, 0), Vector3f(1, 1, 1));
+
+    const std::string directory = std::filesystem::temp_directory_path() / "hussar-guiding-cache-malformed";
+    std::filesystem::create_directories(directory);
+    GuidingCache cache(directory, mesh);
+
+    // moving objects change the keys of the cache
+    TriangleMesh moving = mesh;
+    TriangleMesh::Motion motion;
+    motion.linearVelocity = Vector3f(0, 0, 1);
+    moving.addMotion(motion);
+    Scene scene;
+    scene.tx = { NFAntenna { Vector3f(0, 0, -1), Matrix33f::Identity(), AWRAngularDistribution() } };
+    EXPECT_NE(GuidingCache(directory, moving).key(scene, 0), cache.key(scene, 0));
+
+    GuidingCache::Entry entry;
+    entry.resolution = 4;
+    entry.densities.push_back(std::vector<Float>(16, 1));
+    cache.store(42, entry);
+
+    GuidingCache::Entry loaded;
+    ASSERT_TRUE(cache.load(42, loaded));
+
+    // claim a larger resolution than the file holds
+    const std::string path = directory + "/000000000000002a.guide";
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        const uint32_t resolution = 1 << 13;
+        file.seekp(16);
+        file.write((const char *)&resolution, sizeof(resolution));
+    }
+    EXPECT_FALSE(cache.load(42, loaded));
+
+    std::filesystem::remove_all(directory);
+}
+
+}
@@ -65,4 +65,29 @@ TEST_F(ImageTest, clear) {
     EXPECT_EQ(img.at(1, 1), 0.f);
 }
 
+TEST(WorkerImagesTest, reduce) {
+    // the image does not evenly divide into tiles
+    Image<Float> target(40, 40);
+    target.clear(0.f);
+
+    WorkerImages<Float> workers;
+    workers.configure(40, 40, 2);
+    EXPECT_EQ(workers.tileCount(), 4);
+
+    workers.splat(0, Vector2f(0.f, 0.f), 1.f);
+    workers.splat(1, Vector2f(0.f, 0.f), 2.f);
+    workers.splat(1, Vector2f(0.99f, 0.99f), 4.f);
+
+    for (int tile = 0; tile < workers.tileCount(); ++tile)
+        workers.reduce(target, tile);
+    EXPECT_EQ(target.at(0, 0), 3.f);
+    EXPECT_EQ(target.at(39, 39), 4.f);
+    EXPECT_EQ(target.at(20, 20), 0.f);
+
+    // reduced tiles are cleared
+    for (int tile = 0; tile < workers.tileCount(); ++tile)
+        workers.reduce(target, tile);
+    EXPECT_EQ(target.at(0, 0), 3.f);
+}
+
 }
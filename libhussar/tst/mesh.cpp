@@ -0,0 +1,37 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/mesh.h>
+
+namespace hussar {
+
+// Motions should only apply to the triangles they have been attached to
+TEST(TriangleMeshTest, attaches_motion) {
+    TriangleMesh mesh;
+    mesh.addBox(Vector3f(0, 0, 0), Vector3f(1, 1, 1));
+
+    EXPECT_TRUE(mesh.motionIndices().empty());
+
+    size_t first = mesh.triangleCount();
+    mesh.addBox(Vector3f(2, 0, 0), Vector3f(3, 1, 1));
+
+    TriangleMesh::Motion motion;
+    motion.linearVelocity  = Vector3f(1, 0, 0);
+    motion.angularVelocity = Vector3f(0, 0, 2);
+    motion.center          = Vector3f(2.5f, 0.5f, 0.5f);
+    int index = mesh.addMotion(motion, first);
+
+    mesh.addBox(Vector3f(4, 0, 0), Vector3f(5, 1, 1));
+
+    auto indices = mesh.motionIndices();
+    ASSERT_EQ(indices.size(), mesh.triangleCount());
+    for (size_t i = 0; i < indices.size(); ++i)
+        EXPECT_EQ(indices[i], i >= first && i < 2 * first ? index : TriangleMesh::Static);
+
+    Vector3f v = mesh.motionBuffer[index].velocityAt(Vector3f(3, 0.5f, 0.5f));
+    EXPECT_NEAR(v.x(), 1, 1e-6);
+    EXPECT_NEAR(v.y(), 1, 1e-6);
+    EXPECT_NEAR(v.z(), 0, 1e-6);
+}
+
+}
@@ -0,0 +1,73 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/emitter.h>
+#include <hussar/io/pattern.h>
+
+#include <fstream>
+#include <cstdio>
+#include <cmath>
+
+namespace hussar {
+
+// A tabulated AWR pattern must agree with the analytic one and be sampled consistently with its pdf
+TEST(TabulatedAngularDistributionTest, matches_awr_pattern) {
+    const AWRAngularDistribution awr;
+    const TabulatedAngularDistribution pattern([&](const Vector3f &d) {
+        return Float(awr.evaluate(d).norm() / Vector3f(0, 1, 0).cross(d).norm());
+    }, 128);
+
+    const int n = 64;
+    double integral = 0;
+    for (int a = 0; a < n; ++a) {
+        for (int b = 0; b < n; ++b) {
+            const Vector2f uv((a + 0.5f) / n, (b + 0.5f) / n);
+            const Vector3f d = UniformSampleSphere(uv);
+            integral += pattern.pdf(d) / UniformSpherePdf() / (n * n);
+            EXPECT_NEAR(pattern.evaluate(d).norm(), awr.evaluate(d).norm(), 2e-2 * awr.evaluate(d).norm() + 1e-4);
+
+            Vector3f sampled;
+            const Vector3c weight = pattern.sample(uv, sampled);
+            EXPECT_NEAR(sampled.norm(), 1, 1e-4);
+            EXPECT_NEAR(weight.norm() * pattern.pdf(sampled), pattern.evaluate(sampled).norm(), 1e-3 * weight.norm());
+
+            // the sample can be recovered from the direction
+            const Vector2f inverted = pattern.invert(sampled);
+            EXPECT_NEAR(inverted[0], uv[0], 1e-3);
+            EXPECT_NEAR(inverted[1], uv[1], 1e-3);
+        }
+    }
+    EXPECT_NEAR(integral, 1, 1e-2);
+
+    // most samples go into the hemisphere the antenna is facing
+    int forward = 0;
+    for (int a = 0; a < n; ++a) {
+        for (int b = 0; b < n; ++b) {
+            Vector3f d;
+            pattern.sample(Vector2f((a + 0.5f) / n, (b + 0.5f) / n), d);
+            forward += std::abs(d.z()) > 0.5f;
+        }
+    }
+    EXPECT_GT(forward, n * n / 2);
+}
+
+TEST(TabulatedAngularDistributionTest, loads_measurements) {
+    const std::string path = "pattern_test.txt";
+    {
+        std::ofstream file(path);
+        file << "# azimuth, elevation, gain [dB]" << std::endl;
+        for (int azimuth = -180; azimuth <= 180; azimuth += 10)
+            for (int elevation = -90; elevation <= 90; elevation += 10)
+                file << azimuth << ", " << elevation << ", " << (std::abs(azimuth) < 90 ? 0 : -20) << std::endl;
+    }
+
+    const TabulatedAngularDistribution pattern = loadAntennaPattern(path, 64);
+    std::remove(path.c_str());
+
+    const Vector3f boresight(0, 0, 1), behind(0, 0, -1);
+    EXPECT_NEAR(pattern.evaluate(boresight).norm(), 1, 1e-3);
+    EXPECT_NEAR(pattern.evaluate(behind).norm(), 0.1, 1e-3);
+    EXPECT_THROW(loadAntennaPattern("does_not_exist.txt"), PatternError);
+}
+
+}
@@ -0,0 +1,51 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/piecewise.h>
+
+#include <vector>
+#include <cmath>
+
+namespace hussar {
+
+// Warped samples must be distributed according to the density reported for them
+TEST(PiecewiseConstant2DTest, samples_match_pdf) {
+    const int resolution = 8;
+    std::vector<Float> densities(resolution * resolution);
+    for (int i = 0; i < resolution; ++i)
+        for (int j = 0; j < resolution; ++j)
+            densities[i * resolution + j] = (i == 3) ? 0 : Float(1 + i + 2 * j);
+
+    PiecewiseConstant2D table;
+    table.build(densities.data(), resolution);
+
+    // the density integrates to one
+    double integral = 0;
+    for (int i = 0; i < resolution; ++i)
+        for (int j = 0; j < resolution; ++j)
+            integral += table.pdf(Vector2f((i + 0.5f) / resolution, (j + 0.5f) / resolution));
+    EXPECT_NEAR(integral / (resolution * resolution), 1, 1e-4);
+
+    // a stratified grid of samples populates the cells in proportion to their density
+    const int n = 256;
+    std::vector<int> histogram(resolution * resolution, 0);
+    for (int a = 0; a < n; ++a) {
+        for (int b = 0; b < n; ++b) {
+            Vector2f x((a + 0.5f) / n, (b + 0.5f) / n);
+            const Float pdf = table.sample(x);
+            ASSERT_GT(pdf, 0);
+            ASSERT_FLOAT_EQ(pdf, table.pdf(x));
+            histogram[std::min(int(x[0] * resolution), resolution - 1) * resolution +
+                std::min(int(x[1] * resolution), resolution - 1)]++;
+        }
+    }
+
+    for (int i = 0; i < resolution; ++i) {
+        for (int j = 0; j < resolution; ++j) {
+            const Float pdf = table.pdf(Vector2f((i + 0.5f) / resolution, (j + 0.5f) / resolution));
+            EXPECT_NEAR(histogram[i * resolution + j] / double(n * n), pdf / (resolution * resolution), 2e-3);
+        }
+    }
+}
+
+}
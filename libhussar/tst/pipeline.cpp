@@ -0,0 +1,149 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/frame.h>
+#include <radar/pipeline.h>
+
+#include <random>
+#include <complex>
+#include <cmath>
+
+namespace hussar {
+
+namespace {
+
+radar::FrameConfig testConfig() {
+    radar::FrameConfig config;
+    config.chirpCount      = 8;
+    config.samplesPerChirp = 12;
+    config.channelCount    = 3;
+    return config;
+}
+
+std::vector<RadarFrame> randomFrames(const radar::FrameConfig &config, int count, int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<Float> uniform(-1, 1);
+
+    std::vector<RadarFrame> frames(count);
+    for (auto &frame : frames) {
+        frame.configure(config);
+        for (size_t s = 0; s < frame.sampleCount(); ++s)
+            frame(s) = Complex(uniform(rng), uniform(rng));
+    }
+    return frames;
+}
+
+/// The symmetric Hann window in closed form, normalized to a mean of one (the mean is `(n - 1) / (2n)`).
+double hann(int k, int n) {
+    return (0.5 - 0.5 * std::cos(2 * M_PI * k / (n - 1))) * 2 * n / (n - 1);
+}
+
+/// The magnitude of the spectrum of a window at a normalized frequency (in cycles per sample).
+double spectrum(const std::vector<Float> &window, double frequency) {
+    std::complex<double> sum = 0;
+    for (size_t k = 0; k < window.size(); ++k)
+        sum += double(window[k]) * std::polar(1.0, -2 * M_PI * frequency * k);
+    return std::abs(sum);
+}
+
+}
+
+// The coefficients should match the closed-form definitions of the windows (normalized to a mean of one)
+TEST(WindowTest, closed_form) {
+    const int n = 8;
+    const auto hannWindow = radar::makeWindow(radar::Window::Hann, n);
+    const auto blackman = radar::makeWindow(radar::Window::Blackman, n);
+    for (int k = 0; k < n; ++k) {
+        const double c1 = std::cos(2 * M_PI * k / (n - 1));
+        const double c2 = std::cos(4 * M_PI * k / (n - 1));
+        EXPECT_NEAR(hannWindow[k], hann(k, n), 1e-5);
+        // the mean of the symmetric Blackman window is 0.42 (n - 1) / n
+        EXPECT_NEAR(blackman[k], (0.42 - 0.5 * c1 + 0.08 * c2) * n / (0.42 * (n - 1)), 1e-5);
+    }
+}
+
+// All sidelobes of the Chebyshev window should lie at the requested attenuation
+TEST(WindowTest, chebyshev_sidelobes) {
+    const int n = 16;
+    const double attenuation = 60;
+    const auto window = radar::makeWindow(radar::Window::Chebyshev, n, attenuation);
+
+    const int steps = 4096;
+    const double peak = spectrum(window, 0);
+    EXPECT_NEAR(peak, n, 1e-3 * n);
+
+    // skip the main lobe, which ends at the first minimum of the spectrum
+    int step = 1;
+    while (step < steps / 2 && spectrum(window, double(step + 1) / steps) < spectrum(window, double(step) / steps))
+        ++step;
+
+    double sidelobe = 0;
+    for (; step <= steps / 2; ++step)
+        sidelobe = std::max(sidelobe, spectrum(window, double(step) / steps));
+    EXPECT_NEAR(20 * std::log10(sidelobe / peak), -attenuation, 0.1);
+}
+
+// Batched processing (spread over several workers) should match windowing and transforming each frame
+TEST(PipelineTest, matches_single_frames) {
+    const radar::FrameConfig config = testConfig();
+    const std::vector<RadarFrame> frames = randomFrames(config, 5, 1);
+
+    radar::PipelineConfig pipelineConfig;
+    pipelineConfig.chirp().window  = radar::Window::Hann;
+    pipelineConfig.sample().window = radar::Window::Chebyshev;
+    pipelineConfig.channel().transform = false;
+    pipelineConfig.framesPerTask = 2;
+
+    radar::Pipeline pipeline;
+    pipeline.configure(config, pipelineConfig);
+    auto batch = pipeline.process(frames.data(), int(frames.size()), [](auto &&task) {
+        task(0);
+        task(1);
+    });
+    ASSERT_EQ(batch.frameCount(), int(frames.size()));
+
+    const auto chebyshev = radar::makeWindow(radar::Window::Chebyshev, config.samplesPerChirp);
+    for (size_t f = 0; f < frames.size(); ++f) {
+        RadarFrame reference = frames[f];
+        for (size_t s = 0; s < reference.sampleCount(); ++s) {
+            auto index = reference.makeIndex(s);
+            reference(s) *= Float(hann(index.chirp, config.chirpCount)) * chebyshev[index.sample];
+        }
+        for (int axis = 0; axis < 2; ++axis)
+            radar::fft::transformAxis(&reference(size_t(0)), config.raw, config.NUM_COMPONENTS, axis, -1);
+
+        for (size_t s = 0; s < reference.sampleCount(); ++s)
+            EXPECT_LT(std::abs(batch(int(f), s) - reference(s)), 1e-3);
+    }
+}
+
+// Streaming frames that are already in Fourier space with rectangular windows should reproduce them
+TEST(PipelineTest, streams_fourier_input) {
+    const radar::FrameConfig config = testConfig();
+    const std::vector<RadarFrame> frames = randomFrames(config, 4, 2);
+
+    radar::PipelineConfig pipelineConfig;
+    pipelineConfig.fourierInput = true;
+
+    radar::Pipeline pipeline;
+    pipeline.configure(config, pipelineConfig);
+
+    std::vector<int> batchSizes;
+    size_t next = 0;
+    auto check = [&](radar::ProcessedBatch &batch) {
+        batchSizes.push_back(batch.frameCount());
+        for (int f = 0; f < batch.frameCount(); ++f, ++next) {
+            for (size_t s = 0; s < config.sampleCount(); ++s)
+                EXPECT_LT(std::abs(batch(f, s) - frames[next](s)), 1e-4);
+        }
+    };
+
+    for (const auto &frame : frames)
+        pipeline.push(frame, 3, check);
+    pipeline.flush(check);
+
+    EXPECT_EQ(batchSizes, std::vector<int>({ 3, 1 }));
+    EXPECT_EQ(next, frames.size());
+}
+
+}
@@ -0,0 +1,30 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/sampling.h>
+
+namespace hussar {
+
+TEST(SamplingTest, uniform_sphere_inverse) {
+    const int n = 64;
+    for (int a = 0; a < n; ++a) {
+        for (int b = 0; b < n; ++b) {
+            const Vector2f uv((a + 0.5f) / n, (b + 0.5f) / n);
+            const Vector3f d = UniformSampleSphere(uv);
+
+            const Vector2f inverted = UniformSampleSphereInverse(d);
+            EXPECT_NEAR(inverted[0], uv[0], 1e-5);
+            EXPECT_NEAR(inverted[1], uv[1], 1e-5);
+            EXPECT_TRUE(UniformSampleSphere(inverted).isApprox(d, 1e-5f));
+        }
+    }
+
+    // the poles and the seam of the azimuth remain within the unit square
+    for (const Vector3f &d : { Vector3f(0, 1, 0), Vector3f(0, -1, 0), Vector3f(0, 0, -1), Vector3f(1e-9f, 0, -1) }) {
+        const Vector2f inverted = UniformSampleSphereInverse(d);
+        EXPECT_GE(inverted.minCoeff(), 0);
+        EXPECT_LT(inverted.maxCoeff(), 1);
+    }
+}
+
+}
@@ -0,0 +1,71 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/scheduler.h>
+#include <hussar/core/thread.h>
+
+#include <vector>
+#include <atomic>
+
+namespace hussar {
+
+// Every sample index must be handed out exactly once, even when workers steal from each other
+TEST(SampleSchedulerTest, covers_budget) {
+    const long budget = 100003;
+    std::vector<std::atomic<int>> counts(budget);
+
+    ParallelSession session;
+    SampleScheduler scheduler;
+
+    for (int run = 0; run < 3; ++run) {
+        for (auto &count : counts)
+            count = 0;
+
+        scheduler.reset(budget, session.workerCount());
+        session.parallel([&](int worker) {
+            long begin, end;
+            while (scheduler.next(worker, begin, end)) {
+                for (long index = begin; index < end; ++index)
+                    counts[index]++;
+            }
+        });
+
+        for (long index = 0; index < budget; ++index)
+            ASSERT_EQ(counts[index], 1) << "index " << index;
+    }
+}
+
+// Workers without a range of their own (e.g. when fewer slots than threads exist) still help out
+TEST(SampleSchedulerTest, steals_work) {
+    SampleScheduler scheduler;
+    scheduler.reset(1000, 1);
+
+    long begin, end, total = 0;
+    while (scheduler.next(5, begin, end)) {
+        EXPECT_LT(begin, end);
+        total += end - begin;
+    }
+    EXPECT_EQ(total, 1000);
+}
+
+// Budgets beyond the 32-bit range of a worker are split rather than truncated
+TEST(SampleSchedulerTest, splits_large_budgets) {
+    SampleScheduler scheduler;
+    scheduler.batchDivisor = 1;
+    scheduler.maxBatch = long(UINT32_MAX);
+
+    const long budget = 3 * long(UINT32_MAX) + 7;
+    scheduler.reset(budget, 2);
+
+    long begin, end, total = 0, last = 0;
+    while (scheduler.next(0, begin, end)) {
+        EXPECT_LT(begin, end);
+        EXPECT_LE(end - begin, long(UINT32_MAX));
+        last = std::max(last, end);
+        total += end - begin;
+    }
+    EXPECT_EQ(total, budget);
+    EXPECT_EQ(last, budget);
+}
+
+}
@@ -0,0 +1,121 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/integrators/path.h>
+
+#include "dihedral.h"
+
+#include <algorithm>
+
+namespace hussar {
+
+/// Traces the paths of `PathTracer` with a given frequency, which yields the reference for `heroFrequencies`.
+struct SpectralTracer : PathTracer {
+    void prepare() {
+        configureFrame(dihedralFrameConfig());
+        doGuiding = false;
+        setup();
+        clearFrame();
+    }
+
+    /// The frequency that the path of a sample is traced with.
+    Float pathFrequency(const Scene &scene, long index) {
+        PathState path;
+        startPath(scene, path, index);
+        return path.isect.ray.frequency;
+    }
+
+    /// Like `sample`, but replaces the frequency of the path (unless it is zero).
+    void trace(const Scene &scene, const DihedralRT &rt, long index, Float frequency = 0) {
+        PathState path;
+        startPath(scene, path, index);
+        if (frequency > 0)
+            path.isect.ray.frequency = frequency;
+
+        while (true) {
+            const int receiverCount = beginBounce<DynamicFeatures>(scene, path);
+            for (int receiver = 0; receiver < receiverCount; ++receiver) {
+                if (rt.visible(path.nee[receiver]))
+                    connectReceiver<DynamicFeatures>(scene, path, receiver, 0);
+            }
+
+            if (!prepareExtension(path))
+                break;
+
+            rt.intersect(path.isect);
+            if (!finishExtension<DynamicFeatures>(scene, path))
+                break;
+        }
+    }
+
+    const RadarFrame &accumulatedFrame() const { return frame; }
+};
+
+// Evaluating several frequencies per path must yield the average of paths traced with each of these frequencies
+TEST(SpectralTest, matches_paths_per_frequency) {
+    const Scene scene = dihedralScene();
+    const DihedralRT rt;
+    const long sampleCount = 100000;
+
+    const auto configure = [](SpectralTracer &tracer, int variant) {
+        // small filtering radii make filtering differ between the frequencies of a path
+        tracer.filteringRadius = 2;
+        tracer.filteringMin = 2;
+        tracer.filteringMax = 4;
+        tracer.filteringSphere = variant != 1;
+        tracer.correctPhase = variant == 2;
+    };
+
+    for (int variant = 0; variant < 3; ++variant) {
+        for (int frequencyCount : { 5, 11 }) {
+            SpectralTracer hero;
+            configure(hero, variant);
+            hero.heroFrequencies = frequencyCount;
+            hero.prepare();
+
+            SpectralTracer reference;
+            configure(reference, variant);
+            reference.prepare();
+
+            for (long index = 0; index < sampleCount; ++index) {
+                hero.trace(scene, rt, index);
+
+                const Float frequency = reference.pathFrequency(scene, index);
+                for (int lane = 0; lane < frequencyCount; ++lane)
+                    reference.trace(scene, rt, index,
+                        PathTracer::heroFrequency(scene.rfConfig, frequency, lane, frequencyCount));
+            }
+
+            const RadarFrame &result = hero.accumulatedFrame();
+            const RadarFrame &expected = reference.accumulatedFrame();
+
+            Float peak = 0;
+            for (size_t i = 0; i < expected.sampleCount(); ++i)
+                peak = std::max(peak, std::abs(expected(i)) / frequencyCount);
+            ASSERT_GT(peak, 0) << "for variant " << variant;
+
+            for (size_t i = 0; i < expected.sampleCount(); ++i) {
+                const Complex average = expected(i) / Float(frequencyCount);
+                EXPECT_NEAR(result(i).real(), average.real(), 1e-4f * peak)
+                    << "for variant " << variant << " with " << frequencyCount << " frequencies at sample " << i;
+                EXPECT_NEAR(result(i).imag(), average.imag(), 1e-4f * peak)
+                    << "for variant " << variant << " with " << frequencyCount << " frequencies at sample " << i;
+            }
+        }
+    }
+}
+
+// Frequencies are stratified across the bandwidth of the chirp, starting at the frequency of the path
+TEST(SpectralTest, stratifies_frequencies) {
+    const radar::RFConfig rf = dihedralScene().rfConfig;
+    const Float frequency = rf.startFreq + 0.7f * rf.bandwidth();
+
+    EXPECT_EQ(PathTracer::heroFrequency(rf, frequency, 0, 4), frequency);
+    const Float expected[] = { 0.7f, 0.95f, 0.2f, 0.45f };
+    for (int lane = 0; lane < 4; ++lane) {
+        const Float offset = (PathTracer::heroFrequency(rf, frequency, lane, 4) - rf.startFreq) / rf.bandwidth();
+        EXPECT_NEAR(offset, expected[lane], 1e-3f) << "for lane " << lane;
+    }
+}
+
+}
@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/frame.h>
+
+#include <random>
+#include <cmath>
+
+namespace hussar {
+
+// The standard error estimated from batches must match the spread of the samples
+TEST(BatchStatisticsTest, estimates_standard_error) {
+    radar::FrameConfig config;
+    config.chirpCount = 1;
+    config.samplesPerChirp = 8;
+    config.channelCount = 2;
+
+    RadarFrame frame;
+    frame.configure(config);
+    frame.clear();
+
+    BatchStatistics statistics;
+    statistics.reset(frame);
+
+    // every bin receives samples with mean 1 + 2i and a standard deviation of 0.5 per component
+    const int batches = 400, samplesPerBatch = 16;
+    const Float sigma = 0.5f;
+    std::mt19937 rng(1);
+    std::normal_distribution<Float> noise(0, sigma);
+    for (int b = 0; b < batches; ++b) {
+        for (int s = 0; s < samplesPerBatch; ++s) {
+            for (size_t i = 0; i < frame.sampleCount(); ++i)
+                frame(i) += radar::Complex(1 + noise(rng), 2 + noise(rng));
+        }
+        statistics.record(frame, samplesPerBatch);
+    }
+
+    const Float expected = sigma / std::sqrt(Float(batches * samplesPerBatch));
+    for (size_t i = 0; i < frame.sampleCount(); ++i) {
+        const radar::Complex error = statistics.standardError(i);
+        EXPECT_NEAR(error.real(), expected, 0.1f * expected);
+        EXPECT_NEAR(error.imag(), expected, 0.1f * expected);
+    }
+
+    const BatchStatistics::Estimate estimate = statistics.estimate(frame, statistics.weight());
+    EXPECT_EQ(estimate.batchCount, batches);
+    EXPECT_NEAR(estimate.relativeError, std::sqrt(2.f) * expected / std::sqrt(5.f), 0.1f * expected);
+    EXPECT_LT(estimate.peakRelativeError, 0.01f);
+
+    // samples recorded before the reset do not contribute to the error
+    statistics.reset(frame);
+    statistics.record(frame, samplesPerBatch);
+    EXPECT_TRUE(std::isinf(statistics.standardError(0).real()));
+}
+
+}
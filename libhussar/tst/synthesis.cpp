@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+
+#include <hussar/hussar.h>
+#include <hussar/core/frame.h>
+#include <radar/synthesis.h>
+
+#include <random>
+
+namespace hussar {
+
+// After an FFT over chirps and samples, synthesized IF signals should match leakage-free splatting
+TEST(SynthesizerTest, matches_gridding) {
+    radar::FrameConfig config;
+    config.chirpCount      = 8;
+    config.samplesPerChirp = 60;
+    config.channelCount    = 2;
+
+    const bool gridded[] = { true, true, false };
+    radar::Gridder<> gridder;
+    gridder.configure(config, gridded);
+
+    radar::Synthesizer<> synthesizer;
+    synthesizer.configure(config);
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<Float> uniform(0, 1);
+    for (int i = 0; i < 20; ++i) {
+        RadarFrame::PIndex index;
+        index.chirp   = i % 2 ? uniform(rng) * config.chirpCount : i % config.chirpCount;
+        index.sample  = uniform(rng) * config.samplesPerChirp;
+        index.channel = i % config.channelCount;
+
+        Complex value = radar::polar(Float(1), 2 * Pi * uniform(rng));
+        gridder.splat(index, value);
+        synthesizer.splat(index, value);
+    }
+
+    RadarFrame reference, result;
+    reference.configure(config);
+    reference.clear();
+    result.configure(config);
+    result.clear();
+
+    gridder.resolve(reference);
+    synthesizer.resolve(result);
+    EXPECT_EQ(reference.space(), RadarFrame::FOURIER);
+    EXPECT_EQ(result.space(), RadarFrame::SPATIAL);
+
+    radar::fft::transformAxis(&result(size_t(0)), config.raw, config.NUM_COMPONENTS, 0, -1);
+    radar::fft::transformAxis(&result(size_t(0)), config.raw, config.NUM_COMPONENTS, 1, -1);
+
+    double error = 0, norm = 0;
+    for (size_t s = 0; s < reference.sampleCount(); ++s) {
+        error += std::pow(std::abs(result(s) - reference(s)), 2);
+        norm  += std::pow(std::abs(reference(s)), 2);
+    }
+    EXPECT_LT(std::sqrt(error / norm), 1e-4);
+}
+
+}
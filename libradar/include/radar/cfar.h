@@ -0,0 +1,436 @@
+#ifndef LIBRADAR_CFAR_H
+#define LIBRADAR_CFAR_H
+
+#include <radar/radar.h>
+#include <radar/pipeline.h>
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace radar {
+
+/// The methods that `CFARDetector` can estimate the noise power around a cell with.
+enum class CFARMethod {
+    /// Cell-averaging CFAR (mean power of the training cells).
+    CellAveraging,
+    /// Ordered-statistic CFAR (the k-th smallest power of the training cells), robust against nearby targets.
+    OrderedStatistic
+};
+
+/**
+ * @brief Describes how `CFARDetector` finds targets in radar cubes.
+ *
+ * The training cells of a cell are all cells within `guardCells + trainingCells` bins of the cell (in every
+ * dimension), excluding those within `guardCells` bins. Setting the training cells of a dimension to zero
+ * restricts the noise estimate to the remaining dimensions (e.g. for 2D range-Doppler CFAR).
+ */
+struct CFARConfig {
+    CFARMethod method = CFARMethod::CellAveraging;
+
+    /// @note order matches that of `FrameConfig::raw` (i.e. chirp, sample, channel).
+    int guardCells[FrameConfig::NUM_COMPONENTS] = { 2, 2, 0 };
+    /// @note order matches that of `FrameConfig::raw` (i.e. chirp, sample, channel).
+    int trainingCells[FrameConfig::NUM_COMPONENTS] = { 4, 8, 0 };
+
+    /// The desired probability of false alarms (assuming Rayleigh distributed noise).
+    Float falseAlarmRate = 1e-5;
+
+    /// The rank of the ordered statistic, as fraction of the amount of training cells.
+    Float orderedStatisticRank = 0.75;
+
+    /**
+     * @brief Whether the power of all channels is summed up before detection (range-Doppler CFAR).
+     * The angle of each detection is then found from the strongest channel of the detected cell.
+     */
+    bool integrateChannels = true;
+
+    /// Whether only cells that are not weaker than their direct neighbors are reported.
+    bool peakGrouping = true;
+};
+
+/**
+ * @brief A target found by `CFARDetector`.
+ */
+struct Detection {
+    /// The index of the frame (within the batch) the target has been found in.
+    int frame;
+    /// The fractional chirp index of the target.
+    Float chirp;
+    /// The fractional sample index of the target.
+    Float sample;
+    /// The fractional channel index of the target.
+    Float channel;
+
+    /// The distance of the target (in [m]).
+    Float range;
+    /// The radial velocity of the target (in [m/s]).
+    Float velocity;
+    /// The incident angle of the target (in [rad], see `Frame::GenericIndex::angle`).
+    Float angle;
+    /// The ratio of the power of the cell to the estimated noise power (in [dB]).
+    Float snr;
+};
+
+/**
+ * @brief Finds targets in radar cubes (in Fourier space) using constant false alarm rate detection.
+ *
+ * For cell-averaging CFAR, the noise power around all cells is computed with sliding-window sums, which are
+ * evaluated by differences of prefix sums along one dimension after another (the dimensions of the window are
+ * separable). These passes operate on whole rows of contiguous cells and are vectorized with AVX2 if available.
+ * Ordered-statistic CFAR sorts the training cells of every candidate cell instead, hence it benefits greatly
+ * from `CFARConfig::peakGrouping`.
+ *
+ * The bins wrap around at the borders of the cube, as is the case for the spectra computed by FFTs.
+ *
+ * Frames are distributed over the workers of a `Parallel` callable (see `Pipeline`).
+ */
+class CFARDetector {
+public:
+    static constexpr int NUM_COMPONENTS = FrameConfig::NUM_COMPONENTS;
+
+    /// Configures the detector for radar cubes of a given configuration.
+    void configure(const FrameConfig &frameConfig, const RFConfig &rf, const CFARConfig &config) {
+        m_frameConfig = frameConfig;
+        m_rf = rf;
+        m_config = config;
+
+        m_mapConfig = frameConfig;
+        if (config.integrateChannels)
+            m_mapConfig.channelCount = 1;
+
+        int outerCells = 1, innerCells = 1;
+        for (int i = 0; i < NUM_COMPONENTS; ++i) {
+            // windows that exceed the cube would count cells more than once
+            const int maxRadius = (m_mapConfig.raw[i] - 1) / 2;
+            m_innerRadius[i] = std::min(config.guardCells[i], maxRadius);
+            m_outerRadius[i] = std::min(config.guardCells[i] + config.trainingCells[i], maxRadius);
+
+            outerCells *= 2 * m_outerRadius[i] + 1;
+            innerCells *= 2 * m_innerRadius[i] + 1;
+        }
+        m_trainingCells = outerCells - innerCells;
+
+        const double pfa = config.falseAlarmRate;
+        const int n = std::max(m_trainingCells, 1);
+        if (config.method == CFARMethod::CellAveraging) {
+            m_rank = 0;
+            m_thresholdFactor = n * (std::pow(pfa, -1.0 / n) - 1);
+        } else {
+            m_rank = std::min(std::max(int(config.orderedStatisticRank * n), 1), n);
+            m_thresholdFactor = orderedStatisticFactor(n, m_rank, pfa);
+        }
+    }
+
+    /// Returns the amount of training cells that the noise power of each cell is estimated from.
+    int trainingCellCount() const { return m_trainingCells; }
+
+    /// Finds the targets in all radar cubes of a batch (sorted by frame).
+    template<typename Parallel = Pipeline::Sequential>
+    std::vector<Detection> detect(const ProcessedBatch &batch, Parallel &&parallel = {}) {
+        return detectAll(batch.frameCount(), [&](int frame, size_t sample) {
+            return batch(frame, sample);
+        }, parallel);
+    }
+
+    /// Finds the targets in a batch of radar cubes (sorted by frame).
+    template<typename Allocator, typename Parallel = Pipeline::Sequential>
+    std::vector<Detection> detect(const Frame<Allocator> *frames, int count, Parallel &&parallel = {}) {
+        return detectAll(count, [&](int frame, size_t sample) {
+            return frames[frame](sample);
+        }, parallel);
+    }
+
+private:
+    /// Solves the false alarm rate of OS-CFAR, `prod_{i<k} (n-i) / (n-i+T)`, for the threshold factor `T`.
+    static double orderedStatisticFactor(int n, int k, double pfa) {
+        auto rate = [&](double factor) {
+            double p = 1;
+            for (int i = 0; i < k; ++i)
+                p *= (n - i) / (n - i + factor);
+            return p;
+        };
+
+        double lo = 0, hi = 1;
+        while (rate(hi) > pfa && hi < 1e12)
+            hi *= 2;
+        for (int it = 0; it < 100; ++it) {
+            double mid = (lo + hi) / 2;
+            (rate(mid) > pfa ? lo : hi) = mid;
+        }
+        return hi;
+    }
+
+    /// Computes `dst[i] = a[i] + b[i]` for a row of cells.
+    static void addRow(double *dst, const double *a, const double *b, size_t count) {
+        size_t i = 0;
+#ifdef __AVX2__
+        for (; i + 4 <= count; i += 4)
+            _mm256_storeu_pd(dst + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+#endif
+        for (; i < count; ++i)
+            dst[i] = a[i] + b[i];
+    }
+
+    /// Computes `dst[i] = a[i] - b[i]` for a row of cells.
+    static void subRow(double *dst, const double *a, const double *b, size_t count) {
+        size_t i = 0;
+#ifdef __AVX2__
+        for (; i + 4 <= count; i += 4)
+            _mm256_storeu_pd(dst + i, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+#endif
+        for (; i < count; ++i)
+            dst[i] = a[i] - b[i];
+    }
+
+    /**
+     * @brief Replaces every cell by the sum of all cells within `radius` bins along one dimension
+     * (wrapping around at the borders).
+     *
+     * The lines along the dimension are interleaved in memory, hence the prefix sums are computed for
+     * rows of `stride` contiguous cells at once.
+     */
+    void boxSum(std::vector<double> &data, std::vector<double> &prefix, int axis, int radius) const {
+        if (radius == 0)
+            return;
+
+        size_t stride = 1, outer = 1;
+        for (int i = NUM_COMPONENTS - 1; i > axis; --i)
+            stride *= m_mapConfig.raw[i];
+        for (int i = 0; i < axis; ++i)
+            outer *= m_mapConfig.raw[i];
+
+        const int n = m_mapConfig.raw[axis];
+        const int extent = n + 2 * radius;
+        prefix.resize(size_t(extent + 1) * stride);
+
+        for (size_t o = 0; o < outer; ++o) {
+            double *line = data.data() + o * n * stride;
+
+            // prefix[k] holds the sum of the rows at indices [-radius, k - radius)
+            std::fill(prefix.begin(), prefix.begin() + stride, 0.0);
+            for (int k = 0; k < extent; ++k) {
+                const int row = safe_modulo(k - radius, n);
+                addRow(&prefix[(k + 1) * stride], &prefix[k * stride], line + row * stride, stride);
+            }
+
+            for (int i = 0; i < n; ++i)
+                subRow(line + i * stride, &prefix[(i + 2 * radius + 1) * stride], &prefix[i * stride], stride);
+        }
+    }
+
+    /// Returns the data index of the neighbor of a cell in the detection map (wrapping around at the borders).
+    size_t neighbor(const int *index, int axis, int offset) const {
+        size_t result = 0;
+        for (int i = 0; i < NUM_COMPONENTS; ++i) {
+            result *= m_mapConfig.raw[i];
+            result += i == axis ? safe_modulo(index[i] + offset, m_mapConfig.raw[i]) : index[i];
+        }
+        return result;
+    }
+
+    /// Whether a cell of the detection map is not weaker than its direct neighbors.
+    bool isPeak(const std::vector<double> &power, const int *index, size_t cell) const {
+        for (int i = 0; i < NUM_COMPONENTS; ++i) {
+            if (m_mapConfig.raw[i] < 2)
+                continue;
+            if (power[neighbor(index, i, -1)] > power[cell] || power[neighbor(index, i, +1)] > power[cell])
+                return false;
+        }
+        return true;
+    }
+
+    /// Returns the k-th smallest power of the training cells of a cell.
+    double orderedStatistic(const std::vector<double> &power, const int *index, std::vector<double> &cells) const {
+        cells.clear();
+
+        int offset[NUM_COMPONENTS];
+        for (int i = 0; i < NUM_COMPONENTS; ++i)
+            offset[i] = -m_outerRadius[i];
+
+        while (true) {
+            bool guard = true;
+            size_t cell = 0;
+            for (int i = 0; i < NUM_COMPONENTS; ++i) {
+                guard &= std::abs(offset[i]) <= m_innerRadius[i];
+                cell *= m_mapConfig.raw[i];
+                cell += safe_modulo(index[i] + offset[i], m_mapConfig.raw[i]);
+            }
+            if (!guard)
+                cells.push_back(power[cell]);
+
+            int i = NUM_COMPONENTS - 1;
+            for (; i >= 0; --i) {
+                if (++offset[i] <= m_outerRadius[i])
+                    break;
+                offset[i] = -m_outerRadius[i];
+            }
+            if (i < 0)
+                break;
+        }
+
+        std::nth_element(cells.begin(), cells.begin() + (m_rank - 1), cells.end());
+        return cells[m_rank - 1];
+    }
+
+    /// Computes the fractional location of a peak along one dimension of the detection map.
+    Float refine(const std::vector<double> &power, const int *index, size_t cell, int axis) const {
+        if (m_mapConfig.raw[axis] < 2)
+            return index[axis];
+
+        return interpolatePeak<Float>(
+            std::sqrt(power[neighbor(index, axis, -1)]),
+            std::sqrt(power[cell]),
+            std::sqrt(power[neighbor(index, axis, +1)]),
+            index[axis]
+        );
+    }
+
+    /// Finds the strongest channel of a cell in the radar cube and computes its fractional location.
+    template<typename Source>
+    Float strongestChannel(Source &&source, size_t first) const {
+        const int count = m_frameConfig.channelCount;
+
+        if (count < 2)
+            return 0;
+
+        int best = 0;
+        Float bestMagnitude = -1;
+        for (int c = 0; c < count; ++c) {
+            Float magnitude = std::abs(source(first + c));
+            if (magnitude > bestMagnitude) {
+                best = c;
+                bestMagnitude = magnitude;
+            }
+        }
+
+        return interpolatePeak<Float>(
+            std::abs(source(first + safe_modulo(best - 1, count))),
+            bestMagnitude,
+            std::abs(source(first + safe_modulo(best + 1, count))),
+            best
+        );
+    }
+
+    /// Finds the targets in one frame.
+    template<typename Source>
+    void detectFrame(int frame, Source &&source, std::vector<Detection> &result) const {
+        const size_t mapSize = m_mapConfig.sampleCount();
+        const int channels = m_frameConfig.channelCount;
+
+        std::vector<double> power(mapSize), noise, prefix, cells;
+        if (m_config.integrateChannels) {
+            for (size_t m = 0; m < mapSize; ++m) {
+                double sum = 0;
+                for (int c = 0; c < channels; ++c)
+                    sum += std::norm(source(m * channels + c));
+                power[m] = sum;
+            }
+        } else {
+            for (size_t m = 0; m < mapSize; ++m)
+                power[m] = std::norm(source(m));
+        }
+
+        if (m_config.method == CFARMethod::CellAveraging) {
+            // sum of training cells = sum of outer window - sum of inner window
+            std::vector<double> inner = power;
+            noise = power;
+            for (int i = 0; i < NUM_COMPONENTS; ++i) {
+                boxSum(noise, prefix, i, m_outerRadius[i]);
+                boxSum(inner, prefix, i, m_innerRadius[i]);
+            }
+            subRow(noise.data(), noise.data(), inner.data(), mapSize);
+        }
+
+        const double invTrainingCells = 1.0 / std::max(m_trainingCells, 1);
+
+        int index[NUM_COMPONENTS] = {};
+        for (size_t m = 0; m < mapSize; ++m, advance(index)) {
+            // the estimated noise power of the cell
+            double estimate;
+            if (m_config.method == CFARMethod::CellAveraging) {
+                estimate = noise[m] * invTrainingCells;
+                if (power[m] <= m_thresholdFactor * estimate)
+                    continue;
+                if (m_config.peakGrouping && !isPeak(power, index, m))
+                    continue;
+            } else {
+                // sorting is expensive, hence we first check whether the cell is a peak
+                if (m_config.peakGrouping && !isPeak(power, index, m))
+                    continue;
+                estimate = orderedStatistic(power, index, cells);
+                if (power[m] <= m_thresholdFactor * estimate)
+                    continue;
+            }
+
+            typename Frame<>::PIndex p;
+            p.chirp = refine(power, index, m, 0);
+            p.sample = refine(power, index, m, 1);
+            p.channel = m_config.integrateChannels ?
+                strongestChannel(source, m * channels) :
+                refine(power, index, m, 2);
+
+            Detection detection;
+            detection.frame = frame;
+            detection.chirp = p.chirp;
+            detection.sample = p.sample;
+            detection.channel = p.channel;
+            detection.range = p.distance(m_rf, m_frameConfig) / 2;
+            detection.velocity = p.velocity(m_rf, m_frameConfig);
+            detection.angle = p.angle(m_frameConfig);
+            detection.snr = 10 * std::log10(power[m] / std::max(estimate, 1e-30));
+            result.push_back(detection);
+        }
+    }
+
+    /// Advances a grid-aligned point of the detection map to the next data index.
+    void advance(int *index) const {
+        for (int i = NUM_COMPONENTS - 1; i >= 0; --i) {
+            if (++index[i] < m_mapConfig.raw[i])
+                return;
+            index[i] = 0;
+        }
+    }
+
+    /// Finds the targets in all frames, distributing the frames over the workers.
+    template<typename Source, typename Parallel>
+    std::vector<Detection> detectAll(int count, Source &&source, Parallel &&parallel) {
+        std::vector<std::vector<Detection>> perFrame(count);
+
+        std::atomic<int> nextFrame(0);
+        parallel([&](int) {
+            int frame;
+            while ((frame = nextFrame++) < count) {
+                detectFrame(frame, [&](size_t sample) {
+                    return source(frame, sample);
+                }, perFrame[frame]);
+            }
+        });
+
+        std::vector<Detection> result;
+        for (auto &detections : perFrame)
+            result.insert(result.end(), detections.begin(), detections.end());
+        return result;
+    }
+
+    FrameConfig m_frameConfig = {};
+    /// The configuration of the power map that targets are detected in (one channel if channels are integrated).
+    FrameConfig m_mapConfig = {};
+    RFConfig m_rf = {};
+    CFARConfig m_config;
+
+    int m_innerRadius[NUM_COMPONENTS] = {};
+    int m_outerRadius[NUM_COMPONENTS] = {};
+    int m_trainingCells = 0;
+    int m_rank = 0;
+    double m_thresholdFactor = 1;
+};
+
+}
+
+#endif
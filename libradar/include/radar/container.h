@@ -0,0 +1,238 @@
+#ifndef LIBRADAR_CONTAINER_H
+#define LIBRADAR_CONTAINER_H
+
+#include <radar/radar.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <cstdint>
+
+namespace radar {
+
+/**
+ * @brief Describes the layout of radar cube containers.
+ *
+ * A container starts with a `FileHeader` that describes the radar and frame configuration, followed by
+ * chunks of one or more frames and an index (`ChunkEntry`s followed by `FrameEntry`s), which is located via
+ * the `FileFooter` at the very end of the file. The payload of every chunk starts at a multiple of
+ * `Alignment` bytes, and so does every frame within uncompressed chunks, which allows uncompressed frames to
+ * be accessed in-place when the file is memory-mapped. All values are stored in little-endian byte order.
+ */
+namespace container {
+
+/// The alignment of chunks (and of frames in uncompressed chunks) in bytes.
+constexpr size_t Alignment = 64;
+/// The version of the container format written by `ContainerWriter`.
+constexpr uint32_t Version = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t compression;
+    /// The fields of `RFConfig` (in order of declaration).
+    float rf[6];
+    /// The fields of `FrameConfig` (in order of `FrameConfig::raw`).
+    int32_t frame[FrameConfig::NUM_COMPONENTS];
+    uint32_t framesPerChunk;
+    uint32_t reserved[2];
+};
+
+struct ChunkEntry {
+    /// The offset of the payload of the chunk from the start of the file.
+    uint64_t offset;
+    /// The size of the (possibly compressed) payload in bytes.
+    uint64_t size;
+    uint32_t firstFrame;
+    uint32_t frameCount;
+};
+
+struct FrameEntry {
+    uint32_t chunk;
+    uint32_t reserved;
+    /// A user-defined value describing the frame (e.g. the angle or timestamp of a measurement).
+    double tag;
+};
+
+struct FileFooter {
+    uint64_t indexOffset;
+    uint32_t chunkCount;
+    uint32_t frameCount;
+    char magic[8];
+};
+
+static_assert(sizeof(FileHeader) == Alignment, "unexpected padding in container header");
+static_assert(sizeof(ChunkEntry) == 24 && sizeof(FrameEntry) == 16 && sizeof(FileFooter) == 24,
+    "unexpected padding in container index");
+
+}
+
+/// The compression of the chunks of a radar cube container.
+enum class Compression : uint32_t {
+    None = 0,
+    /// Fast compression (requires liblz4).
+    LZ4  = 1,
+    /// Stronger compression (requires libzstd).
+    Zstd = 2
+};
+
+/// Returns whether libradar has been built with support for a compression method.
+bool supportsCompression(Compression compression);
+
+/// Reports malformed containers and failed I/O operations on containers.
+struct ContainerError : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Maps a file into memory (read-only) for the lifetime of this object.
+ *
+ * On platforms without `mmap`, the file is read into memory instead.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path);
+
+    MappedFile(const MappedFile &) = delete;
+
+    ~MappedFile();
+
+    const char *data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const char *m_data = nullptr;
+    size_t m_size = 0;
+    /// Holds the contents of the file on platforms without `mmap` (aligned like mapped memory).
+    struct alignas(container::Alignment) Block {
+        char bytes[container::Alignment];
+    };
+    std::vector<Block> m_buffer;
+};
+
+struct ContainerOptions {
+    Compression compression = Compression::None;
+    /// The compression level (only used for zstd).
+    int compressionLevel = 3;
+    /// The amount of frames that are compressed (and written) together.
+    int framesPerChunk = 1;
+};
+
+/**
+ * @brief Writes radar cubes into a container file (see `container`).
+ *
+ * Frames are collected until a chunk is complete, which is then written with a single write operation.
+ * The index is written when the writer is closed (or destroyed).
+ */
+class ContainerWriter {
+public:
+    ContainerWriter(
+        const std::string &path,
+        const RFConfig &rf,
+        const FrameConfig &frameConfig,
+        const ContainerOptions &options = {}
+    );
+
+    ContainerWriter(const ContainerWriter &) = delete;
+
+    ~ContainerWriter();
+
+    /**
+     * @brief Appends a radar cube to the container.
+     *
+     * @param tag A user-defined value describing the frame (e.g. the angle or timestamp of a measurement).
+     */
+    void write(const Complex *data, double tag = 0);
+
+    template<typename Allocator>
+    void write(const Frame<Allocator> &frame, double tag = 0) {
+        assert(frame.sampleCount() == m_frameConfig.sampleCount());
+        write(frame.data(), tag);
+    }
+
+    /// Appends consecutive radar cubes (e.g. those of a `ProcessedBatch`) with one tag each.
+    void write(const Complex *data, int count, const double *tags);
+
+    /// Writes the remaining frames and the index and closes the file.
+    void close();
+
+    /// The amount of frames that have been written so far.
+    int frameCount() const { return int(m_frames.size()); }
+
+private:
+    void flushChunk();
+
+    std::ofstream m_file;
+    FrameConfig m_frameConfig;
+    ContainerOptions m_options;
+
+    /// The size of the data of a frame in bytes.
+    size_t m_frameSize;
+    /// The distance between frames in uncompressed chunks in bytes.
+    size_t m_frameStride;
+    /// The frames of the current chunk.
+    std::vector<char> m_chunk;
+    int m_chunkFrames = 0;
+    std::vector<char> m_compressed;
+
+    uint64_t m_offset = 0;
+    std::vector<container::ChunkEntry> m_chunks;
+    std::vector<container::FrameEntry> m_frames;
+};
+
+/**
+ * @brief Provides random access to the radar cubes of a container file by mapping it into memory.
+ *
+ * Uncompressed frames are accessed in-place without any copies. Reading is thread-safe.
+ */
+class ContainerReader {
+public:
+    explicit ContainerReader(const std::string &path);
+
+    ContainerReader(const ContainerReader &) = delete;
+
+    RFConfig rfConfig() const { return m_rf; }
+    FrameConfig frameConfig() const { return m_frameConfig; }
+    Compression compression() const { return m_compression; }
+
+    /// The amount of frames in the container.
+    int frameCount() const { return m_frameCount; }
+
+    /// Returns the user-defined value that a frame has been written with.
+    double tag(int index) const { return m_frames[index].tag; }
+
+    /**
+     * @brief Returns the data of a frame without copying it.
+     *
+     * @return The data of the frame, or `nullptr` if the frame is compressed (see `read`).
+     * The data remains valid for the lifetime of the reader.
+     */
+    const Complex *frame(int index) const;
+
+    /// Copies (and decompresses, if necessary) the data of a frame.
+    void read(int index, Complex *data) const;
+
+    template<typename Allocator>
+    void read(int index, Frame<Allocator> &frame) const {
+        frame.configure(m_frameConfig);
+        read(index, frame.data());
+    }
+
+private:
+    MappedFile m_file;
+
+    RFConfig m_rf;
+    FrameConfig m_frameConfig;
+    Compression m_compression;
+    int m_frameCount;
+    size_t m_frameSize;
+    size_t m_frameStride;
+
+    const container::ChunkEntry *m_chunks;
+    const container::FrameEntry *m_frames;
+};
+
+}
+
+#endif
@@ -0,0 +1,343 @@
+#ifndef LIBRADAR_DATASET_H
+#define LIBRADAR_DATASET_H
+
+#include <radar/radar.h>
+#include <radar/container.h>
+#include <radar/pipeline.h>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace radar {
+
+/**
+ * @brief Provides read-only access to a sequence of radar cubes stored in a file, e.g. a sweep of
+ * measurements or simulations over a range of poses.
+ *
+ * Every frame is described by a tag (e.g. the angle of the pose), which allows aligning datasets
+ * that have been captured at different poses (see `alignByTag`).
+ *
+ * The file is mapped into memory, so that frames can be accessed without copying them (except
+ * for compressed containers, which are decompressed when they are opened).
+ */
+class Dataset {
+public:
+    /// Opens a container file (see `ContainerWriter`), using the tags stored in the container.
+    explicit Dataset(const std::string &path);
+
+    /**
+     * @brief Opens a file of consecutive raw frames (as written by the examples or the visualizer),
+     * whose tags are spaced uniformly (i.e. the tag of the i-th frame is `firstTag + i * tagStep`).
+     */
+    Dataset(const std::string &path, const FrameConfig &frameConfig, double firstTag = 0, double tagStep = 1);
+
+    Dataset(const Dataset &) = delete;
+
+    FrameConfig frameConfig() const { return m_frameConfig; }
+
+    /// The amount of frames in the dataset.
+    int frameCount() const { return int(m_frames.size()); }
+
+    /// The data of a frame (in the order of `Frame::makeIndex`), which remains valid for the lifetime of the dataset.
+    const Complex *frame(int index) const { return m_frames[index]; }
+
+    /// The tag of a frame (e.g. the angle of the pose it has been captured at).
+    double tag(int index) const { return m_tags[index]; }
+
+    /// Copies a frame.
+    template<typename Allocator>
+    void read(int index, Frame<Allocator> &frame) const {
+        frame.configure(m_frameConfig);
+        std::copy(this->frame(index), this->frame(index) + m_frameConfig.sampleCount(), frame.data());
+    }
+
+private:
+    std::unique_ptr<MappedFile> m_file;
+    std::unique_ptr<ContainerReader> m_container;
+    /// The data of compressed containers.
+    std::vector<Complex> m_decompressed;
+
+    FrameConfig m_frameConfig;
+    std::vector<const Complex *> m_frames;
+    std::vector<double> m_tags;
+};
+
+/**
+ * @brief Finds the frame of `references` with the closest tag for each frame of `frames`.
+ *
+ * @return For each frame, the index of the reference frame, or `-1` if no reference frame lies within
+ * the tolerance.
+ */
+std::vector<int> alignByTag(
+    const Dataset &frames,
+    const Dataset &references,
+    double tolerance = std::numeric_limits<double>::infinity()
+);
+
+/// The error metrics between a frame and its reference.
+struct FrameComparison {
+    int frame;
+    int reference;
+    /// The tag of the frame.
+    double tag;
+
+    /// The root mean square difference of the magnitudes of all bins.
+    double magnitudeError;
+    /// The Pearson correlation of the magnitudes of all bins.
+    double correlation;
+    /**
+     * @brief The location of the peak of the reference minus the location of the peak of the frame
+     * (in fractional bins, in the order of `FrameConfig::raw`).
+     */
+    Float peakOffset[FrameConfig::NUM_COMPONENTS];
+};
+
+/// The error metrics between two datasets.
+struct Comparison {
+    /// The metrics for each pair of aligned frames (sorted by frame).
+    std::vector<FrameComparison> frames;
+    /// The mean absolute magnitude difference for each bin (over all pairs of frames).
+    std::vector<Float> binError;
+
+    /// The mean of `FrameComparison::magnitudeError` over all pairs.
+    double magnitudeError = 0;
+    /// The mean of `FrameComparison::correlation` over all pairs.
+    double correlation = 0;
+    /// The mean euclidean length of `FrameComparison::peakOffset` over all pairs.
+    double peakDistance = 0;
+};
+
+struct ComparisonOptions {
+    /**
+     * @brief The factor that the references are multiplied by before comparing them, which allows
+     * calibrating simulations to the (unknown) gain of a sensor.
+     */
+    Float scale = 1;
+    /// The maximum difference of tags for frames to be aligned.
+    double tolerance = std::numeric_limits<double>::infinity();
+};
+
+namespace metrics {
+
+/// Sums over the magnitudes `a` of a frame and `b` of its (scaled) reference.
+struct MagnitudeSums {
+    double a = 0, b = 0;
+    double aa = 0, bb = 0, ab = 0;
+    /// The sum of squared differences.
+    double dd = 0;
+    size_t count = 0;
+
+    double rmse() const { return count ? std::sqrt(dd / count) : 0; }
+
+    double correlation() const {
+        if (count == 0)
+            return 0;
+
+        double covariance = ab - a * b / count;
+        double varianceA = aa - a * a / count;
+        double varianceB = bb - b * b / count;
+        double denominator = std::sqrt(varianceA * varianceB);
+        return denominator > 0 ? covariance / denominator : 0;
+    }
+};
+
+/**
+ * @brief Accumulates the sums of magnitudes of two frames and adds the absolute magnitude differences
+ * to `binError`.
+ *
+ * Magnitudes are computed for eight bins at once with AVX2 (if available). Partial sums are kept in single
+ * precision for blocks of bins and are then added up in double precision.
+ */
+inline void accumulate(
+    const Complex *frame, const Complex *reference, size_t count, Float scale,
+    Float *binError, MagnitudeSums &sums
+) {
+    constexpr size_t BlockSize = 1024;
+
+    for (size_t begin = 0; begin < count; begin += BlockSize) {
+        const size_t end = std::min(begin + BlockSize, count);
+        size_t i = begin;
+        float a = 0, b = 0, aa = 0, bb = 0, ab = 0, dd = 0;
+
+#ifdef __AVX2__
+        const float *x = (const float *)frame;
+        const float *y = (const float *)reference;
+
+        auto magnitudes = [](const float *p) {
+            __m256 lo = _mm256_loadu_ps(p), hi = _mm256_loadu_ps(p + 8);
+            __m256 re = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+            __m256 im = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+            __m256 m = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(re, re), _mm256_mul_ps(im, im)));
+            // the shuffles interleave the 128-bit lanes, restore the order of bins
+            return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(m), 0xD8));
+        };
+        auto horizontalSum = [](__m256 v) {
+            __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            s = _mm_hadd_ps(s, s);
+            s = _mm_hadd_ps(s, s);
+            return _mm_cvtss_f32(s);
+        };
+
+        const __m256 vscale = _mm256_set1_ps(scale);
+        const __m256 signMask = _mm256_set1_ps(-0.f);
+        __m256 va = _mm256_setzero_ps(), vb = va, vaa = va, vbb = va, vab = va, vdd = va;
+        for (; i + 8 <= end; i += 8) {
+            __m256 ma = magnitudes(x + 2 * i);
+            __m256 mb = _mm256_mul_ps(vscale, magnitudes(y + 2 * i));
+            __m256 d = _mm256_sub_ps(ma, mb);
+
+            va = _mm256_add_ps(va, ma);
+            vb = _mm256_add_ps(vb, mb);
+            vaa = _mm256_add_ps(vaa, _mm256_mul_ps(ma, ma));
+            vbb = _mm256_add_ps(vbb, _mm256_mul_ps(mb, mb));
+            vab = _mm256_add_ps(vab, _mm256_mul_ps(ma, mb));
+            vdd = _mm256_add_ps(vdd, _mm256_mul_ps(d, d));
+
+            __m256 error = _mm256_loadu_ps(binError + i);
+            _mm256_storeu_ps(binError + i, _mm256_add_ps(error, _mm256_andnot_ps(signMask, d)));
+        }
+
+        a = horizontalSum(va); b = horizontalSum(vb);
+        aa = horizontalSum(vaa); bb = horizontalSum(vbb); ab = horizontalSum(vab);
+        dd = horizontalSum(vdd);
+#endif
+
+        for (; i < end; ++i) {
+            float ma = std::abs(frame[i]);
+            float mb = scale * std::abs(reference[i]);
+            float d = ma - mb;
+
+            a += ma; b += mb;
+            aa += ma * ma; bb += mb * mb; ab += ma * mb;
+            dd += d * d;
+            binError[i] += std::abs(d);
+        }
+
+        sums.a += a; sums.b += b;
+        sums.aa += aa; sums.bb += bb; sums.ab += ab;
+        sums.dd += dd;
+    }
+
+    sums.count += count;
+}
+
+/// Finds the fractional location of the strongest bin of a frame (see `Frame::frequencyEstimation`).
+inline void peakLocation(const Complex *data, const FrameConfig &config, Float *location) {
+    const size_t count = config.sampleCount();
+
+    size_t best = 0;
+    Float bestPower = -1;
+    for (size_t s = 0; s < count; ++s) {
+        Float power = std::norm(data[s]);
+        if (power > bestPower) {
+            best = s;
+            bestPower = power;
+        }
+    }
+
+    size_t stride = 1;
+    for (int i = FrameConfig::NUM_COMPONENTS - 1; i >= 0; --i) {
+        const int n = config.raw[i];
+        const int b = int((best / stride) % n);
+        const size_t line = best - b * stride;
+
+        location[i] = n < 2 ? b : interpolatePeak<Float>(
+            std::abs(data[line + safe_modulo(b - 1, n) * stride]),
+            std::abs(data[best]),
+            std::abs(data[line + safe_modulo(b + 1, n) * stride]),
+            b
+        );
+        stride *= n;
+    }
+}
+
+}
+
+/**
+ * @brief Computes error metrics between the frames of a dataset (e.g. measurements) and the frames of a
+ * reference dataset with the closest tags (e.g. simulations).
+ *
+ * Frames are distributed over the workers of a `Parallel` callable (see `Pipeline`).
+ */
+template<typename Parallel = Pipeline::Sequential>
+Comparison compare(
+    const Dataset &frames,
+    const Dataset &references,
+    const ComparisonOptions &options = {},
+    Parallel &&parallel = {}
+) {
+    const FrameConfig config = frames.frameConfig();
+    const size_t sampleCount = config.sampleCount();
+    assert(sampleCount == references.frameConfig().sampleCount());
+
+    Comparison result;
+    const std::vector<int> alignment = alignByTag(frames, references, options.tolerance);
+    for (int f = 0; f < frames.frameCount(); ++f) {
+        if (alignment[f] >= 0)
+            result.frames.push_back({ f, alignment[f], frames.tag(f), 0, 0, {} });
+    }
+
+    const int pairCount = int(result.frames.size());
+    std::vector<double> binError(sampleCount, 0);
+    std::mutex mutex;
+
+    std::atomic<int> nextPair(0);
+    parallel([&](int) {
+        std::vector<Float> localBinError(sampleCount, 0);
+
+        int p;
+        while ((p = nextPair++) < pairCount) {
+            FrameComparison &pair = result.frames[p];
+            const Complex *frame = frames.frame(pair.frame);
+            const Complex *reference = references.frame(pair.reference);
+
+            metrics::MagnitudeSums sums;
+            metrics::accumulate(frame, reference, sampleCount, options.scale, localBinError.data(), sums);
+            pair.magnitudeError = sums.rmse();
+            pair.correlation = sums.correlation();
+
+            Float a[FrameConfig::NUM_COMPONENTS], b[FrameConfig::NUM_COMPONENTS];
+            metrics::peakLocation(frame, config, a);
+            metrics::peakLocation(reference, config, b);
+            for (int i = 0; i < FrameConfig::NUM_COMPONENTS; ++i) {
+                // the shortest offset, since bins wrap around
+                Float offset = b[i] - a[i];
+                offset -= config.raw[i] * std::round(offset / config.raw[i]);
+                pair.peakOffset[i] = offset;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t s = 0; s < sampleCount; ++s)
+            binError[s] += localBinError[s];
+    });
+
+    result.binError.resize(sampleCount);
+    for (size_t s = 0; s < sampleCount; ++s)
+        result.binError[s] = pairCount ? Float(binError[s] / pairCount) : 0;
+
+    for (const FrameComparison &pair : result.frames) {
+        double distance = 0;
+        for (Float offset : pair.peakOffset)
+            distance += offset * offset;
+
+        result.magnitudeError += pair.magnitudeError / pairCount;
+        result.correlation += pair.correlation / pairCount;
+        result.peakDistance += std::sqrt(distance) / pairCount;
+    }
+
+    return result;
+}
+
+}
+
+#endif
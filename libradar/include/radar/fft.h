@@ -0,0 +1,85 @@
+#ifndef LIBRADAR_FFT_H
+#define LIBRADAR_FFT_H
+
+#include <radar/radar.h>
+
+#include <string>
+
+namespace radar {
+
+/**
+ * @brief Provides in-place FFTs on radar cubes (and other row-major multi-dimensional arrays).
+ *
+ * Plans of fftw3 are cached process-wide (keyed by the layout of the transform, the alignment of the data
+ * and the amount of threads), so that repeatedly transforming frames of the same configuration does not
+ * require any planning. All functions are thread-safe.
+ *
+ * If libradar has been compiled without fftw3, a direct (quadratic time) DFT is used instead and the
+ * settings for planning, threads and wisdom have no effect. The direct DFT is also used for layouts that
+ * fftw3 fails to plan, which are planned again on their next use.
+ */
+namespace fft {
+
+/// Specifies how much time fftw3 may spend on finding fast plans (see `FFTW_ESTIMATE` etc.).
+enum class Effort {
+    Estimate,
+    Measure,
+    Patient
+};
+
+/**
+ * @brief Sets the effort used for planning transforms of layouts that have not been planned yet.
+ *
+ * Plans found with more effort can be preserved across restarts using `saveWisdom` and `loadWisdom`.
+ */
+void setEffort(Effort effort);
+
+/**
+ * @brief Sets the amount of threads used by transforms that have not been planned yet.
+ *
+ * @note Only has an effect if fftw3 has been built with thread support (i.e. `fftw3f_threads` is available).
+ */
+void setThreadCount(int threadCount);
+
+/// Imports wisdom (i.e. previously found plans) from a file and returns whether this succeeded.
+bool loadWisdom(const std::string &path);
+
+/// Exports the wisdom accumulated by this process to a file and returns whether this succeeded.
+bool saveWisdom(const std::string &path);
+
+/// Releases all cached plans.
+void clearCache();
+
+/**
+ * @brief Performs an in-place multi-dimensional DFT over all axes of a row-major array.
+ *
+ * @param dims The extents of the array (the last axis is contiguous in memory).
+ * @param sign The sign of the exponent, i.e. `-1` for forward and `+1` for (unnormalized) backward
+ * transforms (matching `FFTW_FORWARD` and `FFTW_BACKWARD`).
+ */
+void transform(Complex *data, const int *dims, int rank, int sign);
+
+/**
+ * @brief Performs in-place one-dimensional DFTs along one axis of a row-major multi-dimensional array.
+ *
+ * @see transform
+ */
+void transformAxis(Complex *data, const int *dims, int rank, int axis, int sign);
+
+/**
+ * @brief Performs in-place DFTs over a subset of axes for a batch of consecutive row-major arrays
+ * (e.g. many radar cubes of the same configuration).
+ *
+ * The whole batch is transformed by a single (cached) plan, which lets fftw3 vectorize across arrays
+ * instead of planning and executing each of them separately.
+ *
+ * @param batchCount The amount of arrays, each of which directly follows the previous one in memory.
+ * @param axes Specifies for each axis whether it is transformed.
+ * @see transform
+ */
+void transformBatch(Complex *data, int batchCount, const int *dims, int rank, const bool *axes, int sign);
+
+}
+}
+
+#endif
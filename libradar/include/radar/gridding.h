@@ -0,0 +1,301 @@
+#ifndef LIBRADAR_GRIDDING_H
+#define LIBRADAR_GRIDDING_H
+
+#include <radar/radar.h>
+#include <radar/fft.h>
+
+#include <vector>
+#include <cmath>
+
+namespace radar {
+
+/**
+ * @brief Accumulates contributions at fractional points of a radar cube (in Fourier space) using
+ * non-uniform FFT gridding.
+ *
+ * `Frame::splat` approximates the spectral leakage of each contribution by evaluating the sinc
+ * kernel at up to 33 bins per dimension. Instead, the gridder spreads each contribution onto an
+ * oversampled grid using a compact Kaiser-Bessel kernel (`KernelWidth` taps per dimension). When
+ * the grid is resolved, it is transformed to the time domain, deapodized (i.e. divided by the
+ * Fourier transform of the kernel) and transformed back to the frequency domain, which yields the
+ * exact response of a rectangular window (i.e. the Dirichlet kernel) over all bins, up to the
+ * accuracy of the kernel.
+ *
+ * Only dimensions marked as gridded are treated this way. Contributions are assumed to lie exactly on
+ * grid points in all other dimensions (e.g. the channel dimension), and their coordinates are rounded.
+ *
+ * @note See Beatty et al., "Rapid gridding reconstruction with a minimal oversampling ratio" (2005)
+ * for the choice of kernel parameters.
+ */
+template<typename Allocator = std::allocator<Complex>>
+class Gridder {
+public:
+    using Grid = Frame<Allocator>;
+    using PIndex = typename Grid::PIndex;
+
+    static constexpr int NUM_COMPONENTS = FrameConfig::NUM_COMPONENTS;
+
+    /// The amount of grid points a contribution is spread onto (per gridded dimension).
+    static constexpr int KernelWidth = 6;
+    /// The ratio of grid size to frame size (per gridded dimension).
+    static constexpr int Oversampling = 2;
+
+    /**
+     * @brief Configures the gridder for frames of a given configuration and clears the grid.
+     *
+     * @param gridded Specifies for each dimension (in the order of `FrameConfig::raw`) whether
+     * fractional coordinates are supported.
+     */
+    void configure(const FrameConfig &config, const bool gridded[NUM_COMPONENTS]) {
+        bool unchanged = m_config.sampleCount() > 0;
+        for (int i = 0; i < NUM_COMPONENTS; ++i) {
+            unchanged &= m_config.raw[i] == config.raw[i];
+            unchanged &= m_gridded[i] == (gridded[i] && config.raw[i] > 1);
+        }
+
+        if (unchanged)
+            return;
+
+        m_config = config;
+        m_gridConfig = config;
+        for (int i = 0; i < NUM_COMPONENTS; ++i) {
+            m_gridded[i] = gridded[i] && config.raw[i] > 1;
+            if (m_gridded[i])
+                m_gridConfig.raw[i] *= Oversampling;
+        }
+
+        m_grid.configure(m_gridConfig);
+        m_grid.clear();
+
+        buildKernel();
+        for (int i = 0; i < NUM_COMPONENTS; ++i)
+            buildDeapodization(i);
+    }
+
+    /// The configuration of the frames that this gridder produces.
+    FrameConfig config() const { return m_config; }
+
+    /// The configuration of the oversampled grid.
+    FrameConfig gridConfig() const { return m_gridConfig; }
+
+    /// The oversampled grid that contributions are spread onto by default.
+    Grid &grid() { return m_grid; }
+
+    /// Sets all values of the grid to zero.
+    void clear() {
+        if (m_config.sampleCount() > 0)
+            m_grid.clear();
+    }
+
+    /**
+     * @brief Spreads a contribution onto the grid of this gridder.
+     *
+     * @param index The (fractional) point in the frame that receives the contribution.
+     */
+    void splat(const PIndex &index, Complex value) {
+        splat<true>(m_grid, index, value);
+    }
+
+    /**
+     * @brief Spreads a contribution onto some grid, which must have been configured with `gridConfig()`.
+     *
+     * This allows worker threads to spread contributions onto private grids, which can then be summed
+     * up before resolving (in which case `Atomic` can be disabled).
+     */
+    template<bool Atomic = true>
+    void splat(Grid &grid, const PIndex &index, Complex value) const {
+        int offsets[NUM_COMPONENTS][KernelWidth];
+        Float weights[NUM_COMPONENTS][KernelWidth];
+        int tapCounts[NUM_COMPONENTS];
+
+        for (int i = 0; i < NUM_COMPONENTS; ++i) {
+            const int size = m_gridConfig.raw[i];
+            const int stride = strideOf(i);
+
+            if (!m_gridded[i]) {
+                offsets[i][0] = stride * safe_modulo(int(std::round(index.raw[i])), size);
+                weights[i][0] = 1;
+                tapCounts[i] = 1;
+                continue;
+            }
+
+            // compensates for centering the modes during deapodization
+            const Float f = index.raw[i];
+            value *= polar(Float(1), Float(2 * M_PI) * modulo_one(f * m_modeShift[i] / m_config.raw[i]));
+
+            const Float u = f * Oversampling;
+            const int first = int(std::floor(u)) - KernelWidth / 2 + 1;
+            for (int tap = 0; tap < KernelWidth; ++tap) {
+                offsets[i][tap] = stride * safe_modulo(first + tap, size);
+                weights[i][tap] = kernel(first + tap - u);
+            }
+            tapCounts[i] = KernelWidth;
+        }
+
+        for (int a = 0; a < tapCounts[0]; ++a) {
+            for (int b = 0; b < tapCounts[1]; ++b) {
+                const Float weight = weights[0][a] * weights[1][b];
+                for (int c = 0; c < tapCounts[2]; ++c) {
+                    Complex &v = grid(size_t(offsets[0][a] + offsets[1][b] + offsets[2][c]));
+                    const Complex contribution = (weight * weights[2][c]) * value;
+                    if constexpr (Atomic) {
+                        atomicAdd(&v.real(), contribution.real());
+                        atomicAdd(&v.imag(), contribution.imag());
+                    } else {
+                        v += contribution;
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Transforms the contributions on the grid of this gridder, adds the result to a frame
+     * and clears the grid.
+     *
+     * @note The target frame needs to have the configuration this gridder was configured for.
+     */
+    template<typename TargetAllocator>
+    void resolve(Frame<TargetAllocator> &target) {
+        assert(target.sampleCount() == m_config.sampleCount());
+
+        // to time domain
+        for (int i = 0; i < NUM_COMPONENTS; ++i) {
+            if (m_gridded[i])
+                fft::transformAxis(&m_grid(size_t(0)), m_gridConfig.raw, NUM_COMPONENTS, i, +1);
+        }
+
+        // deapodize and crop to the modes of the frame
+        m_scratch.resize(m_config.sampleCount());
+        typename Grid::Index index, gridIndex;
+        for (size_t s = 0; s < m_scratch.size(); ++s) {
+            size_t rest = s;
+            for (int i = NUM_COMPONENTS - 1; i >= 0; --i) {
+                index.raw[i] = rest % m_config.raw[i];
+                rest /= m_config.raw[i];
+            }
+
+            Float weight = 1;
+            for (int i = 0; i < NUM_COMPONENTS; ++i) {
+                gridIndex.raw[i] = index.raw[i];
+                if (m_gridded[i]) {
+                    const int mode = index.raw[i] < m_config.raw[i] - m_modeShift[i] ?
+                        index.raw[i] :
+                        index.raw[i] - m_config.raw[i];
+                    gridIndex.raw[i] = safe_modulo(mode, m_gridConfig.raw[i]);
+                    weight *= m_deapodization[i][index.raw[i]];
+                }
+            }
+
+            m_scratch[s] = weight * m_grid(gridIndex);
+        }
+
+        // back to frequency domain
+        for (int i = 0; i < NUM_COMPONENTS; ++i) {
+            if (m_gridded[i])
+                fft::transformAxis(m_scratch.data(), m_config.raw, NUM_COMPONENTS, i, -1);
+        }
+
+        for (size_t s = 0; s < m_scratch.size(); ++s) {
+            size_t rest = s;
+            Complex phase = 1;
+            for (int i = NUM_COMPONENTS - 1; i >= 0; --i) {
+                const int k = rest % m_config.raw[i];
+                rest /= m_config.raw[i];
+
+                if (m_gridded[i])
+                    phase *= polar(
+                        Float(1) / m_config.raw[i],
+                        -Float(2 * M_PI) * modulo_one(Float(k * m_modeShift[i]) / m_config.raw[i])
+                    );
+            }
+
+            target(s) += phase * m_scratch[s];
+        }
+        target.setSpace(Frame<TargetAllocator>::FOURIER);
+
+        m_grid.clear();
+    }
+
+private:
+    static constexpr int KernelTableSize = 4096;
+
+    /// Shape parameter of the Kaiser-Bessel kernel (see Beatty et al.).
+    static Float beta() {
+        const double w = KernelWidth, a = Oversampling;
+        return Float(M_PI * std::sqrt(w * w / (a * a) * (a - 0.5) * (a - 0.5) - 0.8));
+    }
+
+    /// Evaluates the modified Bessel function of the first kind of order zero (using its power series).
+    static double besselI0(double x) {
+        double sum = 1, term = 1;
+        for (int k = 1; k < 64 && term > 1e-16 * sum; ++k) {
+            term *= (x / (2 * k)) * (x / (2 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    /// Evaluates the (normalized) Kaiser-Bessel kernel at some distance (in grid points) from a contribution.
+    Float kernel(Float x) const {
+        Float t = std::abs(x) * (KernelTableSize / (KernelWidth / Float(2)));
+        int i = int(t);
+        if (i >= KernelTableSize)
+            return 0;
+
+        Float frac = t - i;
+        return (1 - frac) * m_kernel[i] + frac * m_kernel[i + 1];
+    }
+
+    void buildKernel() {
+        if (!m_kernel.empty())
+            return;
+
+        m_kernel.resize(KernelTableSize + 1);
+        for (int i = 0; i <= KernelTableSize; ++i) {
+            const double x = double(i) / KernelTableSize; // relative to half the kernel width
+            m_kernel[i] = Float(besselI0(beta() * std::sqrt(std::max(1 - x * x, 0.))) / besselI0(beta()));
+        }
+    }
+
+    /// Tabulates the inverse of the Fourier transform of the kernel for all modes of one dimension.
+    void buildDeapodization(int dim) {
+        const int size = m_config.raw[dim];
+        m_modeShift[dim] = size / 2;
+        m_deapodization[dim].assign(size, 1);
+
+        if (!m_gridded[dim])
+            return;
+
+        for (int k = 0; k < size; ++k) {
+            const int mode = k < size - m_modeShift[dim] ? k : k - size;
+            const double xi = double(mode) / m_gridConfig.raw[dim];
+            const double z = std::pow(beta(), 2) - std::pow(M_PI * KernelWidth * xi, 2);
+            const double ft = z > 0 ?
+                KernelWidth * std::sinh(std::sqrt(z)) / std::sqrt(z) :
+                KernelWidth * std::sin(std::sqrt(-z)) / std::max(std::sqrt(-z), 1e-12);
+            m_deapodization[dim][k] = Float(besselI0(beta()) / ft);
+        }
+    }
+
+    size_t strideOf(int dim) const {
+        size_t stride = 1;
+        for (int i = dim + 1; i < NUM_COMPONENTS; ++i)
+            stride *= m_gridConfig.raw[i];
+        return stride;
+    }
+
+    FrameConfig m_config = {};
+    FrameConfig m_gridConfig = {};
+    bool m_gridded[NUM_COMPONENTS] = {};
+    int m_modeShift[NUM_COMPONENTS] = {};
+
+    Grid m_grid;
+    std::vector<Float> m_kernel;
+    std::vector<Float> m_deapodization[NUM_COMPONENTS];
+    std::vector<Complex> m_scratch;
+};
+
+}
+
+#endif
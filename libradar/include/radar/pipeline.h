@@ -0,0 +1,343 @@
+#ifndef LIBRADAR_PIPELINE_H
+#define LIBRADAR_PIPELINE_H
+
+#include <radar/radar.h>
+#include <radar/fft.h>
+#include <radar/window.h>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+
+namespace radar {
+
+/**
+ * @brief Describes how a `Pipeline` processes radar cubes.
+ */
+struct PipelineConfig {
+    /// Describes the processing along one dimension of the radar cube.
+    struct Axis {
+        /// The window applied before transforming this dimension.
+        Window window = Window::Rectangular;
+        /// Whether this dimension is transformed into Fourier space (range, Doppler or angle FFT).
+        bool transform = true;
+    };
+
+    /// @note order matches that of `FrameConfig::raw` (i.e. chirp, sample, channel).
+    Axis axes[FrameConfig::NUM_COMPONENTS];
+
+    /// The sidelobe attenuation of Chebyshev windows (in [dB]).
+    Float chebyshevAttenuation = 80;
+
+    /**
+     * @brief Whether the input frames are in Fourier space (i.e. have been transformed with a rectangular
+     * window), as is the case for the frames produced by simulations.
+     *
+     * Such frames are transformed back (along the transformed dimensions) before the windows are applied,
+     * so that simulated and captured frames can be processed the same way.
+     */
+    bool fourierInput = false;
+
+    /// The amount of frames that are windowed and transformed at once by one worker.
+    int framesPerTask = 8;
+
+    Axis &chirp() { return axes[0]; }
+    Axis &sample() { return axes[1]; }
+    Axis &channel() { return axes[2]; }
+};
+
+/**
+ * @brief Hands out buffers for batches of radar cubes and takes them back once they are no longer needed,
+ * so that processing a stream of frames does not allocate memory for every batch.
+ */
+class BufferPool {
+public:
+    /// Returns a buffer with (at least) the given amount of elements, whose contents are undefined.
+    std::vector<Complex> acquire(size_t size) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto it = m_buffers.begin(); it != m_buffers.end(); ++it) {
+            if (it->size() >= size) {
+                std::vector<Complex> buffer = std::move(*it);
+                m_buffers.erase(it);
+                return buffer;
+            }
+        }
+
+        return std::vector<Complex>(size);
+    }
+
+    /// Returns a buffer to the pool.
+    void release(std::vector<Complex> &&buffer) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffers.push_back(std::move(buffer));
+    }
+
+    /// Releases the memory of all buffers that are currently in the pool.
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffers.clear();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::vector<Complex>> m_buffers;
+};
+
+/**
+ * @brief A batch of processed radar cubes, whose storage is returned to the `BufferPool` of the
+ * pipeline when the batch is destroyed.
+ */
+class ProcessedBatch {
+public:
+    ProcessedBatch() {}
+
+    ProcessedBatch(std::shared_ptr<BufferPool> pool, const FrameConfig &config, int frameCount)
+    : m_pool(std::move(pool)), m_config(config), m_frameCount(frameCount) {
+        m_data = m_pool->acquire(config.sampleCount() * frameCount);
+    }
+
+    ProcessedBatch(ProcessedBatch &&) = default;
+
+    ProcessedBatch &operator=(ProcessedBatch &&other) {
+        release();
+        m_pool = std::move(other.m_pool);
+        m_config = other.m_config;
+        m_frameCount = other.m_frameCount;
+        m_data = std::move(other.m_data);
+        return *this;
+    }
+
+    ~ProcessedBatch() {
+        release();
+    }
+
+    /// The configuration of the radar cubes in this batch.
+    FrameConfig config() const { return m_config; }
+
+    /// The amount of radar cubes in this batch.
+    int frameCount() const { return m_frameCount; }
+
+    /// Reduces the amount of radar cubes in this batch (keeping its storage).
+    void shrink(int frameCount) {
+        assert(frameCount <= m_frameCount);
+        m_frameCount = frameCount;
+    }
+
+    /// Returns the data of a radar cube, laid out the same way as that of `Frame`.
+    Complex *frame(int index) { return m_data.data() + index * m_config.sampleCount(); }
+    const Complex *frame(int index) const { return m_data.data() + index * m_config.sampleCount(); }
+
+    /// Returns the value of a radar cube at some data index (see `Frame::makeIndex`).
+    Complex operator()(int index, size_t sample) const { return frame(index)[sample]; }
+
+    /// Copies a radar cube of this batch into a frame.
+    template<typename Allocator>
+    void copyTo(int index, Frame<Allocator> &frame) const {
+        frame.configure(m_config);
+        const Complex *data = this->frame(index);
+        for (size_t s = 0, n = m_config.sampleCount(); s < n; ++s)
+            frame(s) = data[s];
+    }
+
+private:
+    void release() {
+        if (m_pool)
+            m_pool->release(std::move(m_data));
+        m_pool = nullptr;
+    }
+
+    std::shared_ptr<BufferPool> m_pool;
+    FrameConfig m_config = {};
+    int m_frameCount = 0;
+    std::vector<Complex> m_data;
+};
+
+/**
+ * @brief Applies window functions and range, Doppler and angle FFTs to batches or streams of radar cubes.
+ *
+ * Frames are processed in tasks of `PipelineConfig::framesPerTask` frames, each of which is windowed while
+ * being copied into the batch and is then transformed by a single batched fftw3 plan (see
+ * `fft::transformBatch`). Tasks are distributed over the workers of a `Parallel` callable, which has the
+ * same form as for `Integrator::reduceWorkers` (e.g. a thread pool):
+ *
+ * @code
+ * pipeline.process(frames, count, [](const std::function<void (int)> &task) {
+ *     ThreadPool::get().parallel(task);
+ * });
+ * @endcode
+ *
+ * Frames of any allocator can be processed, hence simulated frames and frames captured by `DataPort`
+ * (with `performFFT` disabled) are treated identically.
+ */
+class Pipeline {
+public:
+    static constexpr int NUM_COMPONENTS = FrameConfig::NUM_COMPONENTS;
+
+    /// Runs all tasks on the calling thread.
+    struct Sequential {
+        template<typename Task>
+        void operator()(Task &&task) const { task(0); }
+    };
+
+    Pipeline() : m_pool(std::make_shared<BufferPool>()) {}
+
+    /**
+     * @brief Configures the pipeline for frames of a given configuration.
+     *
+     * @note Batches that are still being streamed (see `push`) are discarded.
+     */
+    void configure(const FrameConfig &frameConfig, const PipelineConfig &config) {
+        bool resized = frameConfig.sampleCount() != m_frameConfig.sampleCount();
+
+        m_frameConfig = frameConfig;
+        m_config = config;
+        m_config.framesPerTask = std::max(m_config.framesPerTask, 1);
+
+        if (resized)
+            m_pool->clear();
+        m_pending = ProcessedBatch();
+        m_pendingCount = 0;
+
+        buildWindow();
+    }
+
+    FrameConfig frameConfig() const { return m_frameConfig; }
+    const PipelineConfig &config() const { return m_config; }
+
+    /// Processes a batch of frames and returns the resulting radar cubes.
+    template<typename Allocator, typename Parallel = Sequential>
+    ProcessedBatch process(const Frame<Allocator> *frames, int count, Parallel &&parallel = {}) {
+        ProcessedBatch batch(m_pool, m_frameConfig, count);
+        run(batch, [&](int index, Complex *data) {
+            load(frames[index], data);
+            prepare(data);
+        }, parallel);
+        return batch;
+    }
+
+    /**
+     * @brief Appends a frame to the batch that is currently being streamed, and processes the batch
+     * once it holds `batchSize` frames.
+     *
+     * Frames are only copied until the batch is full, which allows the caller to reuse its frame
+     * (e.g. the frame handed out by `DataPort::poll`) immediately.
+     *
+     * @param callback Invoked with the processed batch (as `ProcessedBatch &`) when it is full.
+     */
+    template<typename Allocator, typename Callback, typename Parallel = Sequential>
+    void push(const Frame<Allocator> &frame, int batchSize, Callback &&callback, Parallel &&parallel = {}) {
+        if (m_pendingCount == 0)
+            m_pending = ProcessedBatch(m_pool, m_frameConfig, batchSize);
+
+        load(frame, m_pending.frame(m_pendingCount++));
+        if (m_pendingCount >= m_pending.frameCount())
+            flush(callback, parallel);
+    }
+
+    /// Processes the frames that have been pushed since the last full batch (if any).
+    template<typename Callback, typename Parallel = Sequential>
+    void flush(Callback &&callback, Parallel &&parallel = {}) {
+        if (m_pendingCount == 0)
+            return;
+
+        // the pending batch is processed in-place
+        ProcessedBatch batch = std::move(m_pending);
+        batch.shrink(m_pendingCount);
+        m_pendingCount = 0;
+
+        run(batch, [&](int, Complex *data) {
+            prepare(data);
+        }, parallel);
+        callback(batch);
+    }
+
+private:
+    /// Loads and transforms the frames of a batch in tasks distributed over the workers.
+    template<typename Load, typename Parallel>
+    void run(ProcessedBatch &batch, Load &&load, Parallel &&parallel) {
+        const int taskSize = m_config.framesPerTask;
+        const int end = batch.frameCount();
+
+        std::atomic<int> nextTask(0);
+        parallel([&](int) {
+            int first;
+            while ((first = nextTask.fetch_add(taskSize)) < end) {
+                int last = std::min(first + taskSize, end);
+                for (int i = first; i < last; ++i)
+                    load(i, batch.frame(i));
+
+                fft::transformBatch(
+                    batch.frame(first), last - first,
+                    m_frameConfig.raw, NUM_COMPONENTS, m_transformed, -1
+                );
+            }
+        });
+    }
+
+    /// Copies a frame into a batch.
+    template<typename Allocator>
+    void load(const Frame<Allocator> &frame, Complex *data) const {
+        assert(frame.sampleCount() == m_frameConfig.sampleCount());
+        for (size_t s = 0, n = m_frameConfig.sampleCount(); s < n; ++s)
+            data[s] = frame(s);
+    }
+
+    /// Brings a copied frame into the spatial domain (if needed) and applies the windows.
+    void prepare(Complex *data) const {
+        if (m_config.fourierInput)
+            fft::transformBatch(data, 1, m_frameConfig.raw, NUM_COMPONENTS, m_transformed, +1);
+
+        if (!m_windowed)
+            return;
+
+        for (size_t s = 0, n = m_frameConfig.sampleCount(); s < n; ++s)
+            data[s] *= m_window[s];
+    }
+
+    /// Computes the product of the windows of all dimensions for every element of the radar cube.
+    void buildWindow() {
+        m_windowed = m_config.fourierInput;
+        for (int i = 0; i < NUM_COMPONENTS; ++i) {
+            m_transformed[i] = m_config.axes[i].transform;
+            m_windowed |= m_config.axes[i].window != Window::Rectangular;
+        }
+
+        m_window.assign(m_frameConfig.sampleCount(), 1);
+        if (!m_windowed)
+            return;
+
+        size_t stride = 1;
+        for (int i = NUM_COMPONENTS - 1; i >= 0; --i) {
+            const int count = m_frameConfig.raw[i];
+            const std::vector<Float> window = makeWindow(
+                m_config.axes[i].window, count, m_config.chebyshevAttenuation);
+
+            // the inverse transform of Fourier input is unnormalized, hence we fold its normalization in
+            const Float scale = m_config.fourierInput && m_transformed[i] ? Float(1) / count : 1;
+
+            for (size_t s = 0; s < m_window.size(); ++s)
+                m_window[s] *= scale * window[(s / stride) % count];
+            stride *= count;
+        }
+    }
+
+    FrameConfig m_frameConfig = {};
+    PipelineConfig m_config;
+
+    bool m_transformed[NUM_COMPONENTS] = {};
+    bool m_windowed = false;
+    std::vector<Float> m_window;
+
+    std::shared_ptr<BufferPool> m_pool;
+
+    /// The batch that is currently being streamed (holding copies of the pushed frames).
+    ProcessedBatch m_pending;
+    int m_pendingCount = 0;
+};
+
+}
+
+#endif
@@ -18,10 +18,6 @@
 #include <cmath>
 #include <atomic>
 
-#ifdef RADAR_HAS_FFTW3
-#include <fftw3.h>
-#endif
-
 /**
  * @brief Contains data structures that allow describing radar backends.
  */
@@ -40,6 +36,11 @@ typedef float Float;
  */
 typedef radar::complex<Float> Complex;
 
+namespace fft {
+    /// Performs an in-place DFT over all axes of an array (see `radar/fft.h`).
+    void transform(Complex *data, const int *dims, int rank, int sign);
+}
+
 #ifndef __CUDACC__
 
 namespace {
@@ -89,7 +90,7 @@ namespace {
 /// Modulo operation that always returns positive values.
 template<typename T>
 RADAR_CPU_GPU T safe_modulo(T a, unsigned b) {
-    T mod = a % b;
+    T mod = a % T(b); // signed, otherwise negative values would wrap around incorrectly
     if (mod < 0)
         mod += b;
     return mod;
@@ -103,6 +104,23 @@ RADAR_CPU_GPU Float modulo_one(Float v) {
 
 }
 
+/**
+ * @brief Naive estimation of the fractional location of a peak at bin `b` from the magnitudes `l`, `m`
+ * and `r` of the bin to its left, the bin itself and the bin to its right.
+ *
+ * @note Assumes a rectangular window function.
+ */
+template<typename Float>
+RADAR_CPU_GPU Float interpolatePeak(Float l, Float m, Float r, int b) {
+    if ((l + m + r) == 0)
+        return b;
+
+    if (l > r)
+        return b - l/(l+m);
+    else
+        return b + r/(r+m);
+}
+
 /// The speed of light in free space (in [m/s]).
 constexpr float SPEED_OF_LIGHT = 299792458;
 
@@ -161,6 +179,17 @@ struct FrameConfig {
             count *= raw[i];
         return count;
     }
+
+    /**
+     * @brief The channel of a virtual antenna for TDM-MIMO radar systems, where each combination of transmit
+     * and receive antenna forms one element of a virtual array.
+     *
+     * The channels of all receive antennas for the first transmit antenna come first, followed by those for
+     * the second transmit antenna, and so on (hence `channelCount` should be `transmitters * receiverCount`).
+     */
+    RADAR_CPU_GPU static int virtualChannel(int transmitter, int receiver, int receiverCount) {
+        return transmitter * receiverCount + receiver;
+    }
 };
 
 /**
@@ -280,6 +309,20 @@ struct Frame {
             return delta_p * SPEED_OF_LIGHT / rf.startFreq / 2; /// @todo why startFreq?
         }
 
+        /**
+         * @brief Computes the corresponding incident angle (in [rad], relative to the boresight) from the
+         * channel index, assuming that the channels are spaced by half a wavelength.
+         *
+         * @note This operation is only meaningful when the channel dimension has been transformed.
+         */
+        RADAR_CPU_GPU Float angle(const FrameConfig &f) const {
+            if (f.channelCount < 2)
+                return 0;
+
+            Float s = 2 * nyquistBackfold(channel, f.channelCount);
+            return std::asin(s < -1 ? -1 : (s > 1 ? 1 : s));
+        }
+
         /// Returns the closest grid point (nearest neighbor) in the radar cube.
         template<typename Int = int>
         RADAR_CPU_GPU GenericIndex<Int> rounded() const {
@@ -321,16 +364,13 @@ struct Frame {
         m_config = frame.m_config;
         m_space = frame.m_space;
         m_data = frame.m_data;
-        m_fftPlan = frame.m_fftPlan;
         m_alloc = frame.m_alloc;
 
         frame.m_data = nullptr;
-        frame.m_fftPlan = nullptr;
     }
 
     RADAR_CPU_GPU ~Frame() {
         freeData();
-        destroyFFTPlan();
     }
     
     /**
@@ -348,8 +388,6 @@ struct Frame {
         bool needsRealloc = !m_data || config.sampleCount() != m_config.sampleCount();
         if (needsRealloc) {
             freeData();
-            destroyFFTPlan();
-            
         }
         
         m_config = config;
@@ -408,6 +446,25 @@ struct Frame {
         return m_config;
     }
 
+    /// The space that the data of this frame has to be interpreted in.
+    RADAR_CPU_GPU Space space() const {
+        return m_space;
+    }
+
+    RADAR_CPU_GPU void setSpace(Space space) {
+        m_space = space;
+    }
+
+    /// Returns the raw data of the radar cube (in the order of `makeIndex`).
+    RADAR_CPU_GPU Complex *data() {
+        return m_data;
+    }
+
+    /// Returns the raw data of the radar cube (in the order of `makeIndex`).
+    RADAR_CPU_GPU const Complex *data() const {
+        return m_data;
+    }
+
     /**
      * @brief Performs an in-place FFT operation with rectangular window function
      * on the radar cube.
@@ -415,23 +472,11 @@ struct Frame {
      * This effectively flips the space of this frame (SPATIAL becomes FOURIER or
      * FOURIER becomes SPATIAL).
      * 
+     * @note The plans of fftw3 are cached across frames of the same configuration (see `radar/fft.h`).
      * @todo This should probably also modify the `space` member of this frame.
      */
     RADAR_CPU_GPU void fft() {
-#ifdef RADAR_HAS_FFTW3
-        if (!m_fftPlan) {
-            fftwf_plan_dft_3d(
-                //channelCount, samplesPerChirp, chirpCount,
-                m_config.chirpCount, m_config.samplesPerChirp, m_config.channelCount,
-                (fftwf_complex *)m_data, (fftwf_complex *)m_data, // in-place
-                FFTW_FORWARD, FFTW_ESTIMATE
-            );
-        }
-
-        fftwf_execute((fftwf_plan)m_fftPlan);
-#else
-        assert(!"libradar has been compiled without FFT support!");
-#endif
+        fft::transform(m_data, m_config.raw, FrameConfig::NUM_COMPONENTS, -1);
     }
     
     /**
@@ -560,8 +605,12 @@ struct Frame {
      * 
      * @todo We should perform some approximation of the spectral leakage for the region outside of
      * this range.
+     *
+     * @param Atomic Whether the grid values are incremented using atomic operations. This can be
+     * disabled when the frame is only ever written to by a single thread (e.g. a private frame of
+     * a worker thread), which avoids the cost of compare-and-swap loops.
      */
-    template<int WindowSize = 16>
+    template<int WindowSize = 16, bool Atomic = true>
     RADAR_CPU_GPU void splat(const PIndex &index, Complex value) {
         Index center = index.rounded();
         Float shifts[PIndex::NUM_COMPONENTS];
@@ -582,30 +631,34 @@ struct Frame {
             weight *= std::sin(shiftPi) / M_PI;
         }
 
-        splat<0, WindowSize>(center, value, shifts, weight);
+        splat<0, WindowSize, Atomic>(center, value, shifts, weight);
     }
 
 private:
     /**
      * @brief Helper function for splatting operations.
      */
-    template<int index, int WindowSize>
+    template<int index, int WindowSize, bool Atomic>
     RADAR_CPU_GPU void splat(const Index &center, const Complex &value, const Float *shifts, Float weight) {
         if constexpr (index == Index::NUM_COMPONENTS) {
             // end of recursion
             //printf("splatting at %f+%fi at %lu\n", value.real(), value.imag(), makeIndex(center));
 
-            /// @todo might be bad for performance
             Complex &v = (*this)(center);
-            atomicAdd(&v.real(), weight * value.real());
-            atomicAdd(&v.imag(), weight * value.imag());
+            if constexpr (Atomic) {
+                /// @todo might be bad for performance
+                atomicAdd(&v.real(), weight * value.real());
+                atomicAdd(&v.imag(), weight * value.imag());
+            } else {
+                v += weight * value;
+            }
             return;
         } else {
             // this else block is needed, otherwise template recursion is unbounded
 
             if (shifts[index] == 0) {
                 // delta peak
-                splat<index+1, WindowSize>(center, value, shifts, weight);
+                splat<index+1, WindowSize, Atomic>(center, value, shifts, weight);
                 return;
             }
 
@@ -615,7 +668,7 @@ private:
                 /// @todo what about values that are farther away?
 
                 nextIndex.raw[index] = safe_modulo(center.raw[index] + shift, m_config.raw[index]);
-                splat<index+1, WindowSize>(
+                splat<index+1, WindowSize, Atomic>(
                     nextIndex,
                     value,
                     shifts,
@@ -632,14 +685,7 @@ private:
         Float l = std::abs((*this)(b > 0 ? idx - off : idx + (max-1) * off));
         Float m = std::abs((*this)(idx));
         Float r = std::abs((*this)(b < max-1 ? idx + off : idx - (max-1) * off));
-
-        if ((l + m + r) == 0)
-            return b;
-        
-        if (l > r)
-            return b - l/(l+m);
-        else
-            return b + r/(r+m);
+        return interpolatePeak(l, m, r, b);
     }
     
     /**
@@ -674,25 +720,12 @@ private:
         }
     }
 
-    /**
-     * @brief Releases the FFT plan used by fftw3.
-     * 
-     * @note This functions has no effect if libradar is compiled without fftw3.
-     */
-    void destroyFFTPlan() {
-#ifdef RADAR_HAS_FFTW3
-        fftwf_destroy_plan((fftwf_plan)m_fftPlan);
-#endif
-    }
-
 private:
-    /// Required by fftw3 to compute the FFT operation.
-    void *m_fftPlan = nullptr;
     /// The raw data at the grid-aligned points in this radar cube.
     Complex *m_data = nullptr;
 
     /// The space that the data of this frame has to be interpreted in.
-    Space m_space;
+    Space m_space = FOURIER;
     /// The dimensions of the radar cube described by this frame.
     FrameConfig m_config;
 
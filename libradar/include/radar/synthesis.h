@@ -0,0 +1,194 @@
+#ifndef LIBRADAR_SYNTHESIS_H
+#define LIBRADAR_SYNTHESIS_H
+
+#include <radar/radar.h>
+#include <radar/gridding.h>
+
+#include <cmath>
+
+namespace radar {
+
+/**
+ * @brief Accumulates contributions directly as raw IF signal (i.e. in `Frame::SPATIAL` space), which is
+ * the data a radar sensor captures before any FFT is applied.
+ *
+ * Each contribution at a fractional point of the radar cube (given in Fourier space, as for
+ * `Frame::splat`) is a complex tone along the samples of a chirp. Instead of approximating its
+ * spectral leakage, the tone is synthesized sample by sample, which makes the leakage exact.
+ * The phasor of the tone is advanced by incremental rotation in blocks of `Lanes` samples (which
+ * compilers can vectorize), so that no trigonometric functions need to be evaluated per sample.
+ *
+ * The chirp dimension is kept in Fourier space while accumulating: contributions with integral chirp
+ * coordinates (e.g. without Doppler shift) only touch a single chirp bin, and fractional chirp
+ * coordinates are distributed over all chirp bins using the exact response of a rectangular window.
+ * The chirp dimension is transformed to the time domain when resolving.
+ *
+ * The resulting frame matches the frames produced by `Frame::splat` (up to spectral leakage) after a
+ * forward FFT over chirps and samples. The channel dimension is left untouched (i.e. it is the
+ * index of the receive antenna).
+ */
+template<typename Allocator = std::allocator<Complex>>
+class Synthesizer {
+public:
+    using Buffer = Frame<Allocator>;
+    using PIndex = typename Buffer::PIndex;
+
+    /// The amount of consecutive samples whose phasors are rotated at once.
+    static constexpr int Lanes = 8;
+
+    /// Configures the synthesizer for frames of a given configuration and clears its buffer.
+    void configure(const FrameConfig &config) {
+        bool unchanged = m_config.sampleCount() > 0;
+        for (int i = 0; i < FrameConfig::NUM_COMPONENTS; ++i)
+            unchanged &= m_config.raw[i] == config.raw[i];
+
+        if (unchanged)
+            return;
+
+        m_config = config;
+        m_buffer.configure(config);
+        m_buffer.clear();
+    }
+
+    /// The configuration of the frames that this synthesizer produces.
+    FrameConfig config() const { return m_config; }
+
+    /// The configuration of the buffer that contributions are accumulated in.
+    FrameConfig bufferConfig() const { return m_config; }
+
+    /// The buffer that contributions are accumulated in by default.
+    Buffer &buffer() { return m_buffer; }
+
+    /// Sets all values of the buffer to zero.
+    void clear() {
+        if (m_config.sampleCount() > 0)
+            m_buffer.clear();
+    }
+
+    /**
+     * @brief Synthesizes a contribution into the buffer of this synthesizer.
+     *
+     * @param index The (fractional) point in Fourier space that the contribution corresponds to.
+     */
+    void splat(const PIndex &index, Complex value) {
+        splat<true>(m_buffer, index, value);
+    }
+
+    /**
+     * @brief Synthesizes a contribution into some buffer, which must have been configured with
+     * `bufferConfig()`.
+     *
+     * This allows worker threads to accumulate contributions in private buffers, which can then be
+     * summed up before resolving (in which case `Atomic` can be disabled).
+     */
+    template<bool Atomic = true>
+    void splat(Buffer &buffer, const PIndex &index, Complex value) const {
+        const int chirpCount = m_config.chirpCount;
+        const int channel = safe_modulo(int(std::round(index.channel)), m_config.channelCount);
+
+        value /= Float(m_config.samplesPerChirp);
+
+        const int chirp = int(std::round(index.chirp));
+        if (std::abs(index.chirp - chirp) < 1e-4) {
+            synthesize<Atomic>(buffer, safe_modulo(chirp, chirpCount), channel, index.sample, value);
+            return;
+        }
+
+        // distribute over all chirp bins (exact response of a rectangular window)
+        for (int k = 0; k < chirpCount; ++k) {
+            const Float shift = index.chirp - k;
+            const Float shiftPi = M_PI * shift;
+            const Complex response = polar(
+                std::sin(shiftPi) / (chirpCount * std::sin(shiftPi / chirpCount)),
+                shiftPi * (chirpCount - 1) / chirpCount
+            );
+            synthesize<Atomic>(buffer, k, channel, index.sample, response * value);
+        }
+    }
+
+    /**
+     * @brief Transforms the chirp dimension of the buffer of this synthesizer to the time domain,
+     * adds the result to a frame and clears the buffer.
+     *
+     * @note The target frame needs to have the configuration this synthesizer was configured for.
+     */
+    template<typename TargetAllocator>
+    void resolve(Frame<TargetAllocator> &target) {
+        assert(target.sampleCount() == m_config.sampleCount());
+
+        fft::transformAxis(&m_buffer(size_t(0)), m_config.raw, FrameConfig::NUM_COMPONENTS, 0, +1);
+
+        const Float norm = Float(1) / m_config.chirpCount;
+        for (size_t s = 0, count = m_config.sampleCount(); s < count; ++s)
+            target(s) += norm * m_buffer(s);
+        target.setSpace(Frame<TargetAllocator>::SPATIAL);
+
+        m_buffer.clear();
+    }
+
+private:
+    /// The amount of blocks after which phasors are recomputed to avoid accumulating rounding errors.
+    static constexpr int ResyncInterval = 32;
+
+    /// Adds the tone `value * exp(2 pi i * frequency * n / samplesPerChirp)` to the samples of one chirp.
+    template<bool Atomic>
+    void synthesize(Buffer &buffer, int chirp, int channel, Float frequency, const Complex &value) const {
+        const int sampleCount = m_config.samplesPerChirp;
+        const int stride = m_config.channelCount;
+        Complex *samples = &buffer(size_t(chirp) * sampleCount * stride + channel);
+
+        const Float cycles = frequency / sampleCount;
+        const Complex laneStep = polar(Float(1), Float(2 * M_PI) * cycles);
+        const Complex step = polar(Float(1), Float(2 * M_PI) * modulo_one(Lanes * cycles));
+
+        Float re[Lanes], im[Lanes];
+        for (int block = 0, n0 = 0; n0 < sampleCount; ++block, n0 += Lanes) {
+            if (block % ResyncInterval == 0) {
+                Complex phasor = value * polar(Float(1), Float(2 * M_PI) * modulo_one(n0 * cycles));
+                for (int l = 0; l < Lanes; ++l) {
+                    re[l] = phasor.real();
+                    im[l] = phasor.imag();
+                    phasor *= laneStep;
+                }
+            }
+
+            Complex *chunk = samples + size_t(n0) * stride;
+            if (n0 + Lanes <= sampleCount)
+                accumulate<Atomic, Lanes>(chunk, stride, re, im);
+            else
+                accumulate<Atomic>(chunk, stride, re, im, sampleCount - n0);
+
+            for (int l = 0; l < Lanes; ++l) {
+                const Float r = re[l] * step.real() - im[l] * step.imag();
+                const Float i = re[l] * step.imag() + im[l] * step.real();
+                re[l] = r;
+                im[l] = i;
+            }
+        }
+    }
+
+    /// Adds the phasors of the first `count` lanes to consecutive samples (of some chirp and channel).
+    template<bool Atomic, int FixedCount = 0>
+    static void accumulate(Complex *samples, int stride, const Float *re, const Float *im, int count = FixedCount) {
+        if constexpr (FixedCount > 0)
+            count = FixedCount;
+
+        for (int l = 0; l < count; ++l) {
+            Complex &v = samples[size_t(l) * stride];
+            if constexpr (Atomic) {
+                atomicAdd(&v.real(), re[l]);
+                atomicAdd(&v.imag(), im[l]);
+            } else {
+                v.real() += re[l];
+                v.imag() += im[l];
+            }
+        }
+    }
+
+    FrameConfig m_config = {};
+    Buffer m_buffer;
+};
+
+}
+
+#endif
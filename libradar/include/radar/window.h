@@ -0,0 +1,95 @@
+#ifndef LIBRADAR_WINDOW_H
+#define LIBRADAR_WINDOW_H
+
+#include <radar/radar.h>
+
+#include <vector>
+#include <cmath>
+
+namespace radar {
+
+/**
+ * @brief Window functions that can be applied to radar cubes before transforming them into Fourier space.
+ *
+ * Windows trade a wider main lobe (i.e. a lower resolution) for lower sidelobes, which keeps weak
+ * targets from being buried under the spectral leakage of strong targets.
+ */
+enum class Window {
+    /// No windowing (highest resolution, but sidelobes of only -13 dB).
+    Rectangular,
+    /// Hann window (sidelobes of -31 dB that decay quickly).
+    Hann,
+    /// Blackman window (sidelobes of -58 dB).
+    Blackman,
+    /// Dolph-Chebyshev window (narrowest main lobe for a given, constant sidelobe attenuation).
+    Chebyshev
+};
+
+/**
+ * @brief Computes the (symmetric) coefficients of a window function.
+ *
+ * The coefficients are normalized to a mean of one, so that the peak of a tone that lies exactly on a
+ * frequency bin has the same magnitude as it would have with a rectangular window.
+ *
+ * @param attenuation The sidelobe attenuation of the Chebyshev window (in [dB]).
+ */
+inline std::vector<Float> makeWindow(Window window, int count, Float attenuation = 80) {
+    std::vector<double> w(count, 1.0);
+    const double pi = M_PI;
+    const int order = count - 1;
+
+    if (count > 1) {
+        switch (window) {
+        case Window::Rectangular:
+            break;
+
+        case Window::Hann:
+            for (int k = 0; k < count; ++k)
+                w[k] = 0.5 - 0.5 * std::cos(2 * pi * k / order);
+            break;
+
+        case Window::Blackman:
+            for (int k = 0; k < count; ++k)
+                w[k] = 0.42 - 0.5 * std::cos(2 * pi * k / order) + 0.08 * std::cos(4 * pi * k / order);
+            break;
+
+        case Window::Chebyshev: {
+            // the window is the inverse DFT of a Chebyshev polynomial sampled along the unit circle
+            // (see Lyons, "Understanding Digital Signal Processing", 3rd edition, section 5.10.2)
+            const double beta = std::cosh(std::acosh(std::pow(10.0, std::abs(attenuation) / 20)) / order);
+            std::vector<double> spectrum(count);
+            for (int k = 0; k < count; ++k) {
+                double x = beta * std::cos(pi * k / count);
+                if (x > 1)
+                    spectrum[k] = std::cosh(order * std::acosh(x));
+                else if (x < -1)
+                    spectrum[k] = (order % 2 ? -1 : 1) * std::cosh(order * std::acosh(-x));
+                else
+                    spectrum[k] = std::cos(order * std::acos(x));
+            }
+
+            // the spectrum is real and (anti-)symmetric, hence centering the window yields real coefficients
+            for (int n = 0; n < count; ++n) {
+                double sum = 0;
+                for (int k = 0; k < count; ++k)
+                    sum += spectrum[k] * std::cos(2 * pi * k * (n - order / 2.0) / count);
+                w[n] = sum;
+            }
+            break;
+        }
+        }
+    }
+
+    double mean = 0;
+    for (double v : w)
+        mean += v / count;
+
+    std::vector<Float> result(count);
+    for (int k = 0; k < count; ++k)
+        result[k] = Float(w[k] / mean);
+    return result;
+}
+
+}
+
+#endif
@@ -0,0 +1,357 @@
+#include <radar/container.h>
+
+#include <cstring>
+#include <algorithm>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RADAR_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef RADAR_HAS_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef RADAR_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace radar {
+
+namespace {
+
+const char HeaderMagic[8] = { 'R', 'A', 'D', 'A', 'R', 'C', 'U', 'B' };
+const char FooterMagic[8] = { 'R', 'A', 'D', 'A', 'R', 'I', 'D', 'X' };
+
+size_t alignUp(size_t value) {
+    return (value + container::Alignment - 1) / container::Alignment * container::Alignment;
+}
+
+/// Returns whether all extents of a frame are positive and the size of (an aligned) frame is representable.
+bool isValidFrameConfig(const int32_t extents[FrameConfig::NUM_COMPONENTS]) {
+    size_t sampleLimit = (std::numeric_limits<size_t>::max() - container::Alignment) / sizeof(Complex);
+    for (int i = 0; i < FrameConfig::NUM_COMPONENTS; ++i) {
+        if (extents[i] <= 0 || size_t(extents[i]) > sampleLimit)
+            return false;
+        sampleLimit /= size_t(extents[i]);
+    }
+    return true;
+}
+
+/// Returns the size of the payload of a chunk once decompressed.
+size_t chunkSize(Compression compression, size_t frameSize, size_t frameStride, int frameCount) {
+    // compressed chunks do not need to align their frames
+    return compression == Compression::None ? frameStride * frameCount : frameSize * frameCount;
+}
+
+}
+
+bool supportsCompression(Compression compression) {
+    switch (compression) {
+    case Compression::None: return true;
+#ifdef RADAR_HAS_LZ4
+    case Compression::LZ4: return true;
+#endif
+#ifdef RADAR_HAS_ZSTD
+    case Compression::Zstd: return true;
+#endif
+    default: return false;
+    }
+}
+
+/// MARK: ContainerWriter
+
+ContainerWriter::ContainerWriter(
+    const std::string &path,
+    const RFConfig &rf,
+    const FrameConfig &frameConfig,
+    const ContainerOptions &options
+) : m_frameConfig(frameConfig), m_options(options) {
+    if (!supportsCompression(options.compression))
+        throw ContainerError("libradar has been built without support for the requested compression");
+
+    m_options.framesPerChunk = std::max(m_options.framesPerChunk, 1);
+    m_frameSize = frameConfig.sampleCount() * sizeof(Complex);
+    m_frameStride = alignUp(m_frameSize);
+    m_chunk.resize(chunkSize(options.compression, m_frameSize, m_frameStride, m_options.framesPerChunk));
+
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file)
+        throw ContainerError("could not open " + path + " for writing");
+
+    container::FileHeader header = {};
+    std::memcpy(header.magic, HeaderMagic, sizeof(header.magic));
+    header.version = container::Version;
+    header.compression = uint32_t(options.compression);
+    const float rfFields[] = { rf.startFreq, rf.freqSlope, rf.adcRate, rf.idleTime, rf.rampTime, rf.antennaDelay };
+    std::memcpy(header.rf, rfFields, sizeof(header.rf));
+    for (int i = 0; i < FrameConfig::NUM_COMPONENTS; ++i)
+        header.frame[i] = frameConfig.raw[i];
+    header.framesPerChunk = m_options.framesPerChunk;
+
+    m_file.write((const char *)&header, sizeof(header));
+    m_offset = sizeof(header);
+}
+
+ContainerWriter::~ContainerWriter() {
+    if (!m_file.is_open())
+        return;
+
+    try {
+        close();
+    } catch (const ContainerError &) {
+        // destructors must not throw, call close() explicitly to handle errors
+    }
+}
+
+void ContainerWriter::write(const Complex *data, double tag) {
+    const size_t stride = m_options.compression == Compression::None ? m_frameStride : m_frameSize;
+    std::memcpy(m_chunk.data() + m_chunkFrames * stride, data, m_frameSize);
+
+    m_frames.push_back({ uint32_t(m_chunks.size()), 0, tag });
+    if (++m_chunkFrames == m_options.framesPerChunk)
+        flushChunk();
+}
+
+void ContainerWriter::write(const Complex *data, int count, const double *tags) {
+    const size_t samples = m_frameConfig.sampleCount();
+    for (int i = 0; i < count; ++i)
+        write(data + i * samples, tags ? tags[i] : 0);
+}
+
+void ContainerWriter::flushChunk() {
+    if (m_chunkFrames == 0)
+        return;
+
+    const char *payload = m_chunk.data();
+    size_t size = chunkSize(m_options.compression, m_frameSize, m_frameStride, m_chunkFrames);
+
+    switch (m_options.compression) {
+    case Compression::None:
+        break;
+#ifdef RADAR_HAS_LZ4
+    case Compression::LZ4: {
+        m_compressed.resize(LZ4_compressBound(int(size)));
+        int result = LZ4_compress_default(payload, m_compressed.data(), int(size), int(m_compressed.size()));
+        if (result <= 0)
+            throw ContainerError("lz4 compression failed");
+        payload = m_compressed.data();
+        size = size_t(result);
+        break;
+    }
+#endif
+#ifdef RADAR_HAS_ZSTD
+    case Compression::Zstd: {
+        m_compressed.resize(ZSTD_compressBound(size));
+        size_t result = ZSTD_compress(m_compressed.data(), m_compressed.size(), payload, size, m_options.compressionLevel);
+        if (ZSTD_isError(result))
+            throw ContainerError(std::string("zstd compression failed: ") + ZSTD_getErrorName(result));
+        payload = m_compressed.data();
+        size = result;
+        break;
+    }
+#endif
+    default:
+        assert(false && "unsupported compression");
+    }
+
+    // pad the file so that the chunk starts aligned
+    static const char padding[container::Alignment] = {};
+    const uint64_t start = alignUp(m_offset);
+    m_file.write(padding, start - m_offset);
+    m_file.write(payload, size);
+    if (!m_file)
+        throw ContainerError("failed to write chunk");
+
+    m_chunks.push_back({ start, size, uint32_t(m_frames.size() - m_chunkFrames), uint32_t(m_chunkFrames) });
+    m_offset = start + size;
+    m_chunkFrames = 0;
+}
+
+void ContainerWriter::close() {
+    flushChunk();
+
+    static const char padding[container::Alignment] = {};
+    const uint64_t indexOffset = alignUp(m_offset);
+    m_file.write(padding, indexOffset - m_offset);
+    m_file.write((const char *)m_chunks.data(), m_chunks.size() * sizeof(container::ChunkEntry));
+    m_file.write((const char *)m_frames.data(), m_frames.size() * sizeof(container::FrameEntry));
+
+    container::FileFooter footer = {};
+    footer.indexOffset = indexOffset;
+    footer.chunkCount = uint32_t(m_chunks.size());
+    footer.frameCount = uint32_t(m_frames.size());
+    std::memcpy(footer.magic, FooterMagic, sizeof(footer.magic));
+    m_file.write((const char *)&footer, sizeof(footer));
+
+    m_file.close();
+    if (!m_file)
+        throw ContainerError("failed to write container index");
+}
+
+/// MARK: MappedFile
+
+#ifdef RADAR_HAS_MMAP
+MappedFile::MappedFile(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw ContainerError("could not open " + path);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw ContainerError("could not query the size of " + path);
+    }
+
+    m_size = size_t(info.st_size);
+    if (m_size > 0) {
+        void *mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw ContainerError("could not map " + path);
+        }
+        m_data = (const char *)mapping;
+    }
+    ::close(fd); // the mapping remains valid
+}
+
+MappedFile::~MappedFile() {
+    if (m_data)
+        munmap((void *)m_data, m_size);
+}
+#else
+MappedFile::MappedFile(const std::string &path) {
+    // without memory mapping, the file is read into memory instead
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        throw ContainerError("could not open " + path);
+
+    m_size = size_t(file.tellg());
+    m_buffer.resize((m_size + container::Alignment - 1) / container::Alignment);
+    file.seekg(0);
+    if (!file.read((char *)m_buffer.data(), m_size))
+        throw ContainerError("could not read " + path);
+    m_data = (const char *)m_buffer.data();
+}
+
+MappedFile::~MappedFile() {}
+#endif
+
+/// MARK: ContainerReader
+
+ContainerReader::ContainerReader(const std::string &path) : m_file(path) {
+    if (m_file.size() < sizeof(container::FileHeader) + sizeof(container::FileFooter))
+        throw ContainerError(path + " is not a radar cube container");
+
+    // the footer of malformed files might not be aligned
+    container::FileHeader header;
+    container::FileFooter footer;
+    std::memcpy(&header, m_file.data(), sizeof(header));
+    std::memcpy(&footer, m_file.data() + m_file.size() - sizeof(footer), sizeof(footer));
+
+    const char *error = nullptr;
+    if (std::memcmp(header.magic, HeaderMagic, sizeof(HeaderMagic)) != 0 ||
+        std::memcmp(footer.magic, FooterMagic, sizeof(FooterMagic)) != 0)
+        error = " is not a radar cube container";
+    else if (header.version != container::Version)
+        error = " has an unsupported version";
+    else if (!supportsCompression(Compression(header.compression)))
+        error = " uses a compression that libradar has been built without";
+    else if (!isValidFrameConfig(header.frame))
+        error = " has a malformed frame configuration";
+    else if (footer.frameCount > uint32_t(std::numeric_limits<int>::max()))
+        error = " has too many frames";
+    else {
+        // offsets are compared against the remaining space, since adding them to a crafted offset may overflow
+        const uint64_t indexSpace = m_file.size() - sizeof(container::FileFooter);
+        const uint64_t indexSize =
+            uint64_t(footer.chunkCount) * sizeof(container::ChunkEntry) +
+            uint64_t(footer.frameCount) * sizeof(container::FrameEntry);
+        if (footer.indexOffset % alignof(container::FrameEntry) != 0 ||
+            footer.indexOffset > indexSpace || indexSize > indexSpace - footer.indexOffset)
+            error = " has a truncated index";
+    }
+
+    if (error)
+        throw ContainerError(path + error);
+
+    m_rf.startFreq    = header.rf[0];
+    m_rf.freqSlope    = header.rf[1];
+    m_rf.adcRate      = header.rf[2];
+    m_rf.idleTime     = header.rf[3];
+    m_rf.rampTime     = header.rf[4];
+    m_rf.antennaDelay = header.rf[5];
+    for (int i = 0; i < FrameConfig::NUM_COMPONENTS; ++i)
+        m_frameConfig.raw[i] = header.frame[i];
+    m_compression = Compression(header.compression);
+
+    m_frameCount = int(footer.frameCount);
+    m_frameSize = m_frameConfig.sampleCount() * sizeof(Complex);
+    m_frameStride = alignUp(m_frameSize);
+    m_chunks = (const container::ChunkEntry *)(m_file.data() + footer.indexOffset);
+    m_frames = (const container::FrameEntry *)(m_chunks + footer.chunkCount);
+
+    for (uint32_t c = 0; c < footer.chunkCount; ++c) {
+        const container::ChunkEntry &chunk = m_chunks[c];
+        if (chunk.offset > footer.indexOffset || chunk.size > footer.indexOffset - chunk.offset)
+            throw ContainerError(path + " has a truncated chunk");
+        if (uint64_t(chunk.firstFrame) + chunk.frameCount > footer.frameCount ||
+            (m_compression == Compression::None &&
+                (chunk.size % m_frameStride != 0 || chunk.size / m_frameStride != chunk.frameCount)))
+            throw ContainerError(path + " has a malformed chunk");
+    }
+
+    // frames are accessed through their chunks, hence the index must refer to chunks that contain them
+    for (uint32_t f = 0; f < footer.frameCount; ++f) {
+        const uint32_t c = m_frames[f].chunk;
+        if (c >= footer.chunkCount || f < m_chunks[c].firstFrame || f - m_chunks[c].firstFrame >= m_chunks[c].frameCount)
+            throw ContainerError(path + " has a malformed frame index");
+    }
+}
+
+const Complex *ContainerReader::frame(int index) const {
+    if (m_compression != Compression::None)
+        return nullptr;
+
+    const container::ChunkEntry &chunk = m_chunks[m_frames[index].chunk];
+    return (const Complex *)(m_file.data() + chunk.offset + (index - chunk.firstFrame) * m_frameStride);
+}
+
+void ContainerReader::read(int index, Complex *data) const {
+    if (const Complex *frame = this->frame(index)) {
+        std::memcpy(data, frame, m_frameSize);
+        return;
+    }
+
+    const container::ChunkEntry &chunk = m_chunks[m_frames[index].chunk];
+    const char *payload = m_file.data() + chunk.offset;
+    std::vector<char> buffer(chunkSize(m_compression, m_frameSize, m_frameStride, chunk.frameCount));
+
+    bool success = false;
+    switch (m_compression) {
+#ifdef RADAR_HAS_LZ4
+    case Compression::LZ4:
+        success = LZ4_decompress_safe(payload, buffer.data(), int(chunk.size), int(buffer.size())) == int(buffer.size());
+        break;
+#endif
+#ifdef RADAR_HAS_ZSTD
+    case Compression::Zstd:
+        success = ZSTD_decompress(buffer.data(), buffer.size(), payload, chunk.size) == buffer.size();
+        break;
+#endif
+    default:
+        (void)payload;
+        break;
+    }
+
+    if (!success)
+        throw ContainerError("failed to decompress chunk");
+
+    std::memcpy(data, buffer.data() + (index - chunk.firstFrame) * m_frameSize, m_frameSize);
+}
+
+}
@@ -0,0 +1,73 @@
+#include <radar/dataset.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace radar {
+
+Dataset::Dataset(const std::string &path) {
+    m_container.reset(new ContainerReader(path));
+    m_frameConfig = m_container->frameConfig();
+
+    const int count = m_container->frameCount();
+    const size_t sampleCount = m_frameConfig.sampleCount();
+    if (m_container->compression() != Compression::None)
+        m_decompressed.resize(sampleCount * count);
+
+    for (int i = 0; i < count; ++i) {
+        const Complex *frame = m_container->frame(i);
+        if (!frame) {
+            // compressed frames cannot be accessed in-place
+            Complex *data = m_decompressed.data() + i * sampleCount;
+            m_container->read(i, data);
+            frame = data;
+        }
+
+        m_frames.push_back(frame);
+        m_tags.push_back(m_container->tag(i));
+    }
+}
+
+Dataset::Dataset(const std::string &path, const FrameConfig &frameConfig, double firstTag, double tagStep)
+: m_frameConfig(frameConfig) {
+    m_file.reset(new MappedFile(path));
+
+    const size_t frameSize = frameConfig.sampleCount() * sizeof(Complex);
+    if (frameSize == 0 || m_file->size() % frameSize != 0)
+        throw ContainerError("the size of " + path + " is not a multiple of the frame size");
+
+    const int count = int(m_file->size() / frameSize);
+    for (int i = 0; i < count; ++i) {
+        m_frames.push_back((const Complex *)(m_file->data() + i * frameSize));
+        m_tags.push_back(firstTag + i * tagStep);
+    }
+}
+
+std::vector<int> alignByTag(const Dataset &frames, const Dataset &references, double tolerance) {
+    // sort the references by tag, so that the closest one can be found by binary search
+    std::vector<int> order(references.frameCount());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return references.tag(a) < references.tag(b);
+    });
+
+    std::vector<int> result(frames.frameCount(), -1);
+    for (int f = 0; f < frames.frameCount(); ++f) {
+        const double tag = frames.tag(f);
+        auto it = std::lower_bound(order.begin(), order.end(), tag, [&](int r, double t) {
+            return references.tag(r) < t;
+        });
+
+        double bestDistance = tolerance;
+        if (it != order.end() && std::abs(references.tag(*it) - tag) <= bestDistance) {
+            bestDistance = std::abs(references.tag(*it) - tag);
+            result[f] = *it;
+        }
+        if (it != order.begin() && std::abs(references.tag(*(it - 1)) - tag) < bestDistance)
+            result[f] = *(it - 1);
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,308 @@
+#include <radar/fft.h>
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <tuple>
+
+#ifdef RADAR_HAS_FFTW3
+#include <fftw3.h>
+#endif
+
+namespace radar {
+namespace fft {
+
+namespace {
+
+/// One dimension of a transform (or of the loop over transforms), with strides in elements.
+struct Dimension {
+    int n;
+    int stride;
+};
+
+#ifdef RADAR_HAS_FFTW3
+/// Identifies plans that can be reused (fftw3 plans may be executed on any data with the same layout and alignment).
+struct PlanKey {
+    std::vector<int> layout; ///< extents and strides of the transform dimensions, followed by those of the loops
+    int transformRank;
+    int sign;
+    int threadCount;
+    bool aligned;
+
+    bool operator<(const PlanKey &other) const {
+        return
+            std::tie(layout, transformRank, sign, threadCount, aligned) <
+            std::tie(other.layout, other.transformRank, other.sign, other.threadCount, other.aligned);
+    }
+};
+
+class PlanCache {
+public:
+    ~PlanCache() {
+        clear();
+    }
+
+    void clear() {
+        for (auto &entry : m_plans)
+            fftwf_destroy_plan(entry.second);
+        m_plans.clear();
+    }
+
+    /// Returns a plan for in-place transforms of the given layout, planning it if necessary (or null if planning fails).
+    fftwf_plan get(
+        Complex *data,
+        const std::vector<Dimension> &transform,
+        const std::vector<Dimension> &loops,
+        int sign
+    ) {
+        PlanKey key;
+        for (const std::vector<Dimension> *list : { &transform, &loops }) {
+            for (const Dimension &dim : *list) {
+                key.layout.push_back(dim.n);
+                key.layout.push_back(dim.stride);
+            }
+        }
+        key.transformRank = int(transform.size());
+        key.sign = sign;
+        key.threadCount = threadCount;
+        key.aligned = fftwf_alignment_of((float *)data) == 0;
+
+        auto it = m_plans.find(key);
+        if (it != m_plans.end())
+            return it->second;
+
+        // failed plans are not cached, so that planning is retried (e.g. once memory is available again)
+        fftwf_plan result = plan(transform, loops, sign, key.aligned);
+        if (result)
+            m_plans[key] = result;
+        return result;
+    }
+
+    std::mutex mutex;
+    Effort effort = Effort::Estimate;
+    int threadCount = 1;
+
+private:
+    fftwf_plan plan(
+        const std::vector<Dimension> &transform,
+        const std::vector<Dimension> &loops,
+        int sign, bool aligned
+    ) {
+        std::vector<fftwf_iodim> transformDims, loopDims;
+        size_t extent = 1;
+        for (const Dimension &dim : transform) {
+            transformDims.push_back({ dim.n, dim.stride, dim.stride });
+            extent += size_t(dim.n - 1) * dim.stride;
+        }
+        for (const Dimension &dim : loops) {
+            loopDims.push_back({ dim.n, dim.stride, dim.stride });
+            extent += size_t(dim.n - 1) * dim.stride;
+        }
+
+        unsigned flags = effort == Effort::Patient ? FFTW_PATIENT :
+                         effort == Effort::Measure ? FFTW_MEASURE :
+                                                     FFTW_ESTIMATE;
+        if (!aligned)
+            flags |= FFTW_UNALIGNED;
+
+#ifdef RADAR_HAS_FFTW3_THREADS
+        fftwf_plan_with_nthreads(threadCount);
+#endif
+
+        // planning (other than FFTW_ESTIMATE) overwrites the array, hence we plan on scratch memory
+        fftwf_complex *scratch = fftwf_alloc_complex(extent);
+        fftwf_plan result = fftwf_plan_guru_dft(
+            int(transformDims.size()), transformDims.data(),
+            int(loopDims.size()), loopDims.data(),
+            scratch, scratch, // in-place
+            sign < 0 ? FFTW_FORWARD : FFTW_BACKWARD, flags
+        );
+        fftwf_free(scratch);
+        return result;
+    }
+
+    std::map<PlanKey, fftwf_plan> m_plans;
+};
+
+PlanCache &planCache() {
+    static PlanCache cache;
+    return cache;
+}
+#endif
+
+/// Performs the in-place transforms described by `transform` with a direct DFT, one transform dimension at a time.
+void transformDirect(
+    Complex *data,
+    const std::vector<Dimension> &transform,
+    const std::vector<Dimension> &loops,
+    int sign
+) {
+    for (size_t axis = 0; axis < transform.size(); ++axis) {
+        const int n = transform[axis].n;
+        const int stride = transform[axis].stride;
+
+        std::vector<Dimension> lines = loops;
+        for (size_t i = 0; i < transform.size(); ++i) {
+            if (i != axis)
+                lines.push_back(transform[i]);
+        }
+
+        std::vector<Complex> twiddles(n), line(n);
+        for (int k = 0; k < n; ++k)
+            twiddles[k] = polar(Float(1), Float(sign * 2 * M_PI * k / n));
+
+        std::vector<int> counter(lines.size(), 0);
+        while (true) {
+            Complex *base = data;
+            for (size_t i = 0; i < lines.size(); ++i)
+                base += size_t(counter[i]) * lines[i].stride;
+
+            for (int j = 0; j < n; ++j)
+                line[j] = base[size_t(j) * stride];
+
+            for (int k = 0; k < n; ++k) {
+                Complex sum = 0;
+                for (int j = 0; j < n; ++j)
+                    sum += line[j] * twiddles[(size_t(j) * k) % n];
+                base[size_t(k) * stride] = sum;
+            }
+
+            // advance to the next line
+            size_t i = 0;
+            for (; i < lines.size(); ++i) {
+                if (++counter[i] < lines[i].n)
+                    break;
+                counter[i] = 0;
+            }
+            if (i == lines.size())
+                break;
+        }
+    }
+}
+
+/// Performs the in-place transforms described by `transform`, repeated over the loops described by `loops`.
+void execute(
+    Complex *data,
+    const std::vector<Dimension> &transform,
+    const std::vector<Dimension> &loops,
+    int sign
+) {
+#ifdef RADAR_HAS_FFTW3
+    fftwf_plan plan;
+    {
+        PlanCache &cache = planCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        plan = cache.get(data, transform, loops, sign);
+    }
+
+    if (plan) {
+        // executing plans is thread-safe
+        fftwf_execute_dft(plan, (fftwf_complex *)data, (fftwf_complex *)data);
+        return;
+    }
+#endif
+
+    transformDirect(data, transform, loops, sign);
+}
+
+/// Transforms the selected axes of consecutive row-major arrays (axes of extent one are skipped).
+void transformAxes(
+    Complex *data, int batchCount,
+    const int *dims, int rank,
+    const std::vector<bool> &axes,
+    int sign
+) {
+    std::vector<Dimension> transform, loops;
+
+    int stride = 1;
+    for (int i = rank - 1; i >= 0; --i) {
+        if (dims[i] > 1)
+            (axes[i] ? transform : loops).push_back({ dims[i], stride });
+        stride *= dims[i];
+    }
+
+    if (batchCount > 1)
+        loops.push_back({ batchCount, stride });
+
+    if (transform.empty())
+        return;
+
+    // fftw3 expects the dimensions in row-major order
+    std::reverse(transform.begin(), transform.end());
+    std::reverse(loops.begin(), loops.end());
+    execute(data, transform, loops, sign);
+}
+
+}
+
+void setEffort(Effort effort) {
+#ifdef RADAR_HAS_FFTW3
+    PlanCache &cache = planCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.effort = effort;
+#else
+    (void)effort;
+#endif
+}
+
+void setThreadCount(int threadCount) {
+#ifdef RADAR_HAS_FFTW3_THREADS
+    PlanCache &cache = planCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+
+    static bool initialized = fftwf_init_threads() != 0;
+    if (initialized)
+        cache.threadCount = std::max(threadCount, 1);
+#else
+    (void)threadCount;
+#endif
+}
+
+bool loadWisdom(const std::string &path) {
+#ifdef RADAR_HAS_FFTW3
+    PlanCache &cache = planCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    return fftwf_import_wisdom_from_filename(path.c_str()) != 0;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+bool saveWisdom(const std::string &path) {
+#ifdef RADAR_HAS_FFTW3
+    PlanCache &cache = planCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    return fftwf_export_wisdom_to_filename(path.c_str()) != 0;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+void clearCache() {
+#ifdef RADAR_HAS_FFTW3
+    PlanCache &cache = planCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.clear();
+#endif
+}
+
+void transform(Complex *data, const int *dims, int rank, int sign) {
+    const std::vector<bool> axes(rank, true);
+    transformAxes(data, 1, dims, rank, axes, sign);
+}
+
+void transformAxis(Complex *data, const int *dims, int rank, int axis, int sign) {
+    std::vector<bool> axes(rank, false);
+    axes[axis] = true;
+    transformAxes(data, 1, dims, rank, axes, sign);
+}
+
+void transformBatch(Complex *data, int batchCount, const int *dims, int rank, const bool *axes, int sign) {
+    transformAxes(data, batchCount, dims, rank, std::vector<bool>(axes, axes + rank), sign);
+}
+
+}
+}
@@ -1,5 +0,0 @@
-#include <radar/radar.h>
-
-namespace radar {
-
-}
@@ -65,10 +65,7 @@ private:
         
         /// log data in the meanwhile
         
-        for (size_t i = 0; i < acc.sampleCount(); ++i) {
-            auto v = acc(i);
-            file.write((const char *)(&v), 2 * sizeof(float));
-        }
+        file.write((const char *)acc.data(), acc.sampleCount() * sizeof(radar::Complex));
     }
     
     void start() {
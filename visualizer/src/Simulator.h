@@ -154,16 +154,21 @@ public:
                 -1, 0, 0;
 
             // place the antennas
-            scene->rx = NFAntenna {
-                rotation * Vector3f(896_mm, 67_mm, -5_mm), // location of the receive antenna
-                rotation * facing,                         // local coordinate system of the antenna
-                AWRAngularDistribution()                   // radiation pattern
-            };
-            scene->tx = NFAntenna {
+            // the receive antennas are spaced by half a wavelength, one per channel of the frame
+            const float rxSpacing = radar::SPEED_OF_LIGHT / scene->rfConfig.startFreq / 2;
+            scene->rx.clear();
+            for (int channel = 0; channel < Scene::MaxReceivers; ++channel) {
+                scene->rx.push_back(NFAntenna {
+                    rotation * Vector3f(896_mm, 67_mm, -5_mm + channel * rxSpacing), // location of the receive antenna
+                    rotation * facing,                                               // local coordinate system of the antenna
+                    AWRAngularDistribution()                                         // radiation pattern
+                });
+            }
+            scene->tx = { NFAntenna {
                 rotation * Vector3f(896_mm, 67_mm, -7_mm), // location of the transmit antenna
                 rotation * facing,                         // local coordinate system of the antenna
                 AWRAngularDistribution()                   // radiation pattern
-            };
+            } };
 
             lastAngle = angle;
 